@@ -0,0 +1,14 @@
+QT -= gui
+QT += core
+CONFIG += console c++11
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = audiocodec_bench
+
+# 直接编译客户端的编解码源文件，测的就是会议里用的那份实现
+INCLUDEPATH += ../../client/Headers/comm
+
+HEADERS += ../../client/Headers/comm/audiocodec.h
+SOURCES += \
+    main.cpp \
+    ../../client/Sources/comm/audiocodec.cpp
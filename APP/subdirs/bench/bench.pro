@@ -0,0 +1,4 @@
+TEMPLATE = subdirs
+
+# 独立的性能基准程序，不参与客户端/服务端运行；直接运行可执行文件查看结果
+SUBDIRS += audiocodec_bench orderdb_bench
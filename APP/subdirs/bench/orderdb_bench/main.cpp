@@ -0,0 +1,202 @@
+// 工单库基准：按固定种子生成 orders / recordings / recording_files，
+// 分别在“改造前”（回滚日志、无索引、每次现编语句）和“改造后”（WAL + DbPool::tune、
+// 迁移第 1 步的索引、语句编译一次反复执行）两种配置下，测 get_orders / get_recordings /
+// get_recording_files / update_order 所用 SQL 的平均耗时
+// 用法：orderdb_bench [行数...]，默认 10000 100000 1000000；每条查询默认 100 次，环境变量 BENCH_ITERS 可改
+#include <QCoreApplication>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QVariantList>
+#include <cstdio>
+#include <functional>
+#include "dbpool.h"
+
+namespace {
+
+const char* const kStatuses[] = {"待处理", "处理中", "已完成", "已拒绝"};
+constexpr int kFactoryUsers = 200;
+
+// 与服务端迁移第 1 步一致
+const char* const kIndexes[] = {
+    "CREATE INDEX IF NOT EXISTS idx_orders_factory_status ON orders(factory_user, status)",
+    "CREATE INDEX IF NOT EXISTS idx_orders_status ON orders(status)",
+    "CREATE INDEX IF NOT EXISTS idx_recordings_room ON recordings(room_id)",
+    "CREATE INDEX IF NOT EXISTS idx_recording_files_rec ON recording_files(recording_id)",
+};
+
+// 与 AuthServer 各 action 拼出的 SQL 一致（工单列表按客户端分页，每页 100 行）
+const char* const kSqlFactoryOrders =
+    "SELECT o.id, o.title, o.desc, o.status, o.factory_user FROM orders o WHERE 1=1"
+    " AND o.factory_user=? AND o.status=? AND o.id > ? ORDER BY o.id LIMIT ?";
+const char* const kSqlExpertOrders =
+    "SELECT o.id, o.title, o.desc, o.status, o.factory_user FROM orders o WHERE 1=1"
+    " AND o.status=? AND o.id > ? ORDER BY o.id LIMIT ?";
+const char* const kSqlRecordings =
+    "SELECT id, order_id, room_id, started_at, ended_at, title FROM recordings WHERE 1=1 AND room_id=?";
+const char* const kSqlFiles =
+    "SELECT f.id, f.recording_id, f.user, f.file_path, f.kind "
+    "FROM recording_files f JOIN recordings r ON f.recording_id=r.id WHERE 1=1 AND r.room_id=?";
+const char* const kSqlUpdate = "UPDATE orders SET status=? WHERE id=?";
+
+quint32 g_rnd = 1;
+int rnd(int n) { g_rnd = g_rnd * 1103515245u + 12345u; return int((g_rnd >> 8) % quint32(n)); }
+
+bool exec(QSqlDatabase& db, const QString& sql)
+{
+    QSqlQuery q(db);
+    if (q.exec(sql)) return true;
+    std::fprintf(stderr, "SQL failed: %s\n  %s\n", qPrintable(q.lastError().text()), qPrintable(sql));
+    return false;
+}
+
+bool seed(QSqlDatabase& db, int rows)
+{
+    g_rnd = 20240601u;   // 固定种子，各次运行数据一致
+    if (!exec(db, "CREATE TABLE orders (id INTEGER PRIMARY KEY, title TEXT, desc TEXT, status TEXT, factory_user TEXT)")
+        || !exec(db, "CREATE TABLE recordings (id INTEGER PRIMARY KEY AUTOINCREMENT, order_id TEXT, room_id TEXT, started_at INTEGER, ended_at INTEGER, title TEXT)")
+        || !exec(db, "CREATE TABLE recording_files (id INTEGER PRIMARY KEY AUTOINCREMENT, recording_id INTEGER, user TEXT, file_path TEXT, kind TEXT)"))
+        return false;
+
+    db.transaction();
+    QSqlQuery o(db), r(db), f(db);
+    o.prepare("INSERT INTO orders (id, title, desc, status, factory_user) VALUES (?, ?, ?, ?, ?)");
+    r.prepare("INSERT INTO recordings (order_id, room_id, started_at, ended_at, title) VALUES (?, ?, ?, ?, ?)");
+    f.prepare("INSERT INTO recording_files (recording_id, user, file_path, kind) VALUES (?, ?, ?, ?)");
+    for (int i = 1; i <= rows; ++i) {
+        o.addBindValue(i);
+        o.addBindValue(QString("设备巡检 %1").arg(i));
+        o.addBindValue(QString("第 %1 号产线振动异常，需要远程专家协助").arg(rnd(1000)));
+        o.addBindValue(QString::fromUtf8(kStatuses[rnd(4)]));
+        o.addBindValue(QString("factory%1").arg(rnd(kFactoryUsers)));
+        if (!o.exec()) { std::fprintf(stderr, "seed orders: %s\n", qPrintable(o.lastError().text())); return false; }
+
+        // 每个工单一次录制、一个文件，房间号即工单号
+        const QString room = QString::number(1 + rnd(rows));
+        r.addBindValue(room);
+        r.addBindValue(room);
+        r.addBindValue(qint64(1700000000000LL) + i * 1000LL);
+        r.addBindValue(qint64(1700000000000LL) + i * 1000LL + 600000);
+        r.addBindValue(QString("会议录制 %1").arg(i));
+        if (!r.exec()) return false;
+        f.addBindValue(i);
+        f.addBindValue(QString("expert%1").arg(rnd(50)));
+        f.addBindValue(QString("knowledge/%1/%2.mp4").arg(room).arg(i));
+        f.addBindValue(QStringLiteral("video"));
+        if (!f.exec()) return false;
+    }
+    return db.commit();
+}
+
+struct Mode {
+    const char* name;
+    bool cached;   // 语句编译一次反复执行（DbPool::prepared 的做法）
+};
+
+// 跑 iters 次，返回平均毫秒；每次都把结果行读完，与服务端拼 JSON 前的取数一致
+double timeQuery(QSqlDatabase& db, const Mode& m, const char* sql, int iters,
+                 const std::function<QVariantList(int)>& binds)
+{
+    QSqlQuery cached(db);
+    if (m.cached) cached.prepare(sql);
+    QElapsedTimer t;
+    t.start();
+    for (int i = 0; i < iters; ++i) {
+        QSqlQuery fresh(db);
+        QSqlQuery& q = m.cached ? cached : fresh;
+        if (!m.cached) q.prepare(sql);
+        for (const QVariant& v : binds(i)) q.addBindValue(v);
+        if (!q.exec()) {
+            std::fprintf(stderr, "query failed: %s\n", qPrintable(q.lastError().text()));
+            return -1;
+        }
+        while (q.next()) { q.value(0); q.value(1); }
+        q.finish();
+    }
+    return t.nsecsElapsed() / 1e6 / iters;
+}
+
+void runQueries(QSqlDatabase& db, const Mode& m, int rows, int iters)
+{
+    auto status = [](int i) { return QString::fromUtf8(kStatuses[i % 4]); };
+    auto room = [rows](int i) { return QString::number(1 + (i * 7919) % rows); };
+
+    const double fo = timeQuery(db, m, kSqlFactoryOrders, iters, [&](int i) {
+        return QVariantList{QString("factory%1").arg(i % kFactoryUsers), status(i), 0, 100};
+    });
+    const double eo = timeQuery(db, m, kSqlExpertOrders, iters, [&](int i) {
+        return QVariantList{status(i), 0, 100};
+    });
+    const double rc = timeQuery(db, m, kSqlRecordings, iters, [&](int i) { return QVariantList{room(i)}; });
+    const double fl = timeQuery(db, m, kSqlFiles, iters, [&](int i) { return QVariantList{room(i)}; });
+    // 写：每次一个自动提交事务，体现日志模式与 synchronous 的差别
+    const double up = timeQuery(db, m, kSqlUpdate, iters, [&](int i) {
+        return QVariantList{status(i + 1), 1 + (i * 104729) % rows};
+    });
+
+    std::printf("  %-8s get_orders(factory) %8.3f  get_orders(expert) %8.3f  get_recordings %8.3f"
+                "  get_recording_files %8.3f  update_order %8.3f  ms\n",
+                m.name, fo, eo, rc, fl, up);
+}
+
+bool runSize(const QString& dir, int rows, int iters)
+{
+    const QString file = QString("%1/orders_%2.db").arg(dir).arg(rows);
+    const QString conn = QString("bench_%1").arg(rows);
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", conn);
+        db.setDatabaseName(file);
+        if (!db.open()) {
+            std::fprintf(stderr, "open %s: %s\n", qPrintable(file), qPrintable(db.lastError().text()));
+        } else {
+            QElapsedTimer t;
+            t.start();
+            ok = seed(db, rows);
+            std::printf("rows=%d  seed %.1f s\n", rows, t.elapsed() / 1000.0);
+
+            if (ok) {
+                // 改造前：默认回滚日志、无索引
+                exec(db, "PRAGMA journal_mode=DELETE");
+                runQueries(db, Mode{"before", false}, rows, iters);
+
+                // 改造后：WAL + 连接调优 + 迁移索引 + 语句缓存
+                t.start();
+                for (const char* sql : kIndexes) ok = ok && exec(db, sql);
+                exec(db, "ANALYZE");
+                std::printf("  indexes built in %.1f s\n", t.elapsed() / 1000.0);
+                exec(db, "PRAGMA journal_mode=WAL");
+                DbPool::tune(db);
+                runQueries(db, Mode{"after", true}, rows, iters);
+            }
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(conn);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QList<int> sizes;
+    for (int i = 1; i < argc; ++i) if (atoi(argv[i]) > 0) sizes << atoi(argv[i]);
+    if (sizes.isEmpty()) sizes = {10000, 100000, 1000000};
+    const int iters = qEnvironmentVariableIsSet("BENCH_ITERS") ? qMax(1, qEnvironmentVariableIntValue("BENCH_ITERS")) : 100;
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "cannot create temp dir\n");
+        return 1;
+    }
+    std::printf("orderdb_bench: %d iterations per query, mean ms per call\n", iters);
+    for (int rows : sizes) {
+        if (!runSize(dir.path(), rows, iters)) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+QT -= gui
+QT += core sql
+CONFIG += console c++11
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = orderdb_bench
+
+# 复用服务端的连接调优（DbPool::tune）
+INCLUDEPATH += ../../server/src
+
+HEADERS += ../../server/src/dbpool.h
+SOURCES += \
+    main.cpp \
+    ../../server/src/dbpool.cpp
@@ -4,6 +4,8 @@
 #include <QWidget>
 #include "comm/commwidget.h"
 #include <QVector>
+#include <QJsonArray>
+#include <QJsonObject>
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class ClientExpert; }
@@ -18,6 +20,8 @@ struct OrderInfo {
 
 class KnowledgePanel;  // 企业知识库
 class DevicePanel;     // 设备管理
+class OrderPager;      // 工单分页
+class OrderFeed;       // 工单变更推送
 
 class ClientExpert : public QWidget
 {
@@ -45,7 +49,12 @@ private:
     KnowledgePanel* kbPanel_    = nullptr; // 企业知识库页（嵌入）
     DevicePanel*    devicePanel_ = nullptr; // 设备管理页（嵌入）
 
+    OrderPager* pager_ = nullptr;   // 工单表按需分页
+    OrderFeed*  feed_  = nullptr;   // 工单变更推送
+
     void refreshOrders();
+    void applyOrders(const QJsonArray& arr, bool first);
+    void applyOrderChange(const QString& op, const QJsonObject& order);
     void updateTabEnabled();
     void sendUpdateOrder(int orderId, const QString& status);
 };
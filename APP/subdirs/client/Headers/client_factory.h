@@ -3,6 +3,8 @@
 
 #include <QWidget>
 #include <QVector>
+#include <QJsonArray>
+#include <QJsonObject>
 
 #include <client_expert.h>     // 复用 OrderInfo
 #include "comm/commwidget.h"
@@ -13,6 +15,8 @@ QT_END_NAMESPACE
 
 class DevicePanel;     // 设备管理
 class KnowledgePanel;  // 企业知识库
+class OrderPager;      // 工单分页
+class OrderFeed;       // 工单变更推送
 
 class ClientFactory : public QWidget
 {
@@ -36,7 +40,12 @@ private:
     QVector<OrderInfo> orders;
     bool deletingOrder = false;
 
+    OrderPager* pager_ = nullptr;   // 工单表按需分页
+    OrderFeed*  feed_  = nullptr;   // 工单变更推送
+
     void refreshOrders();
+    void applyOrders(const QJsonArray& arr, bool first);
+    void applyOrderChange(const QString& op, const QJsonObject& order);
     void updateTabEnabled();
     void sendCreateOrder(const QString& title, const QString& desc);
 
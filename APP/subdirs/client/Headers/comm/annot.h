@@ -15,25 +15,92 @@ public:
         QVector<QPointF> pts;
         QString text;
         bool finished{false};
+        qint64 lastMs{0};       // 最近一次 begin/update 的时间，判断“没等到 end”的笔画
+
+        // 存储内部状态
+        QRectF bounds;          // 点的归一化包围盒（不含线宽）
+        bool   hasBounds{false};
+        int    pos{-1};         // 在 order_ 中的位置
+        bool   alive{true};
     };
 
     static Tool toolFromString(const QString& s);
+    static QString toolName(Tool t);
+
+    // 点坐标二进制负载（MSG_ANNOT 的 bin）：每点 u16 x, u16 y（BigEndian），归一化坐标乘 65535
+    static QByteArray packPoints(const QVector<QPointF>& pts);
+    static QVector<QPointF> unpackPoints(const QByteArray& bin);
 
-    bool applyEvent(const QJsonObject& e);
+    // bin 非空时点坐标取自 bin，否则按旧格式读 json 的 "pts" 数组
+    bool applyEvent(const QJsonObject& e, const QByteArray& bin = QByteArray());
 
+    // 已结束的笔画（order_ 中连续结束的前缀）按目标尺寸栅格化进缓存层，只增量补画新结束的笔画；
+    // 其后仍在绘制中的笔画每次现画。撤销/改动已缓存笔画只按网格索引重画受影响的区域，清空时缓存作废
     void paint(QPainter& p, const QSize& size) const;
 
+    // 自上次调用以来有变化的区域（已按线宽外扩），供画布局部重绘；没有变化时返回空矩形
+    QRect takeDirty(const QSize& size);
+
     void clear();
 
     bool undoLastByOwner(const QString& owner);
 
+    // 作者离开或 end 丢失时，未结束的笔画会一直挡住 finishedPrefix，后面的笔画都无法进缓存层。
+    // finishOwner 把该作者所有进行中的笔画按已结束处理；finishIdle 处理超过 idleMs 没有新点的笔画。
+    // 返回被结束的笔画数
+    static constexpr int kOpenTimeoutMs = 10000;
+    int  finishOwner(const QString& owner);
+    int  finishIdle(qint64 idleMs = kOpenTimeoutMs);
+
+    // 把当前存活笔画按绘制顺序还原成 begin(+end) 事件（点坐标在 bin 里），给中途入会的成员重放
+    // 事件不含 roomId/target，由调用方补上
+    QVector<QPair<QJsonObject, QByteArray>> snapshotEvents() const;
+    int  strokeCount() const { return live_; }
+
     static inline QPointF denorm(const QPointF& n, const QSize& size) {
         return QPointF(n.x() * size.width(), n.y() * size.height());
     }
 
 private:
+    struct Layer {
+        QImage  img;
+        int     baked  = 0;   // 已画进 img 的 order_ 前缀长度
+        int     erased = 0;   // 已修补到 erased_ 的第几项
+        quint64 rev    = 0;
+    };
+    static constexpr int kMaxLayers  = 4;    // 画布、缩略图、录制等不同尺寸各一份
+    static constexpr int kGrid       = 16;   // 空间索引：归一化画面切成 kGrid x kGrid 格
+    static constexpr int kCompactMin = 64;   // 墓碑至少这么多且多于存活笔画时整理存储
+    static constexpr int kMaxErased  = 256;  // 待修补区域上限，超过后缓存层整体重画
+
     static void drawArrow(QPainter& p, const QPointF& a, const QPointF& b, int width, const QColor& color);
+    static void paintStroke(QPainter& p, const Stroke& s, const QSize& size);
+    static int  padPx(const Stroke& s);   // 线宽、箭头、文字超出点包围盒的像素
+    static QRect pixelRect(const QRectF& n, int pad, const QSize& size);
+
+    int  finishedPrefix() const;
+    int  newStroke(Stroke s);
+    void finish(int h);
+    void kill(int h);
+    void grow(int h, const QVector<QPointF>& pts);
+    void touch(const QRectF& n);          // 记入 dirty_
+    void noteErased(const QRectF& n, int pad);   // 记入 erased_，顺带丢掉各层都已修补的部分
+    void indexCells(int h, const QRectF& oldB, bool hadOld);
+    QVector<int> query(const QRectF& n) const;   // 包围盒与 n 相交的存活笔画，按绘制顺序
+    void compact();
+    void invalidate() { ++rev_; erased_.clear(); }
+
+    QVector<Stroke> store_;               // 句柄即下标；撤销只打墓碑，整理时重排
+    QVector<int>    order_;               // 绘制顺序（句柄，含墓碑）
+    QHash<QString, int> byId_;
+    QHash<QString, QVector<int>> undo_;   // 每个作者的撤销栈（句柄，出栈时跳过墓碑）
+    QVector<QVector<int>> cells_ = QVector<QVector<int>>(kGrid * kGrid);
+    QVector<QPair<QRectF, int>> erased_;  // 被撤销/改动笔画的区域与外扩像素，各缓存层按序修补
+    int live_ = 0, dead_ = 0, maxPad_ = 0;
+    mutable int prefix_ = 0;              // finishedPrefix 的扫描位置，只会前进
+    QRectF dirty_;
+    bool   hasDirty_ = false;
 
-    QHash<QString, Stroke> strokes_;
-    QStringList order_;
-};
\ No newline at end of file
+    quint64 rev_ = 0;                        // 缓存层需要整体重画时递增
+    mutable QHash<quint64, Layer> layers_;   // key: (w << 32) | h
+};
@@ -8,6 +8,8 @@ public:
     explicit AnnotCanvas(QWidget* parent=nullptr);
 
     void setActiveModel(AnnotModel* m) { model_ = m; update(); }
+    // 只重绘模型自上次以来变化的区域
+    void refreshDirty() { if (model_) { const QRect r = model_->takeDirty(size()); if (!r.isEmpty()) update(r); } }
 
     void setEnabledDrawing(bool on);
     bool isDrawingEnabled() const { return drawingEnabled_; }
@@ -19,7 +21,8 @@ public:
     void setTargetKey(const QString& k) { targetKey_ = k; }
 
 signals:
-    void annotateEvent(const QJsonObject& ev);
+    // pts 为 AnnotModel::packPoints 编码的点坐标
+    void annotateEvent(const QJsonObject& ev, const QByteArray& pts);
 
 protected:
     void paintEvent(QPaintEvent*) override;
@@ -31,6 +34,10 @@ private:
     void emitBegin(const QPointF& npt);
     void emitUpdate(const QVector<QPointF>& npts);
     void emitEnd();
+    void flushPending();
+
+    static constexpr int    kFlushMs     = 16;     // 鼠标移动按约一帧批量发送
+    static constexpr double kSimplifyPx  = 0.75;   // 自由笔迹 RDP 简化容差（画布像素）
 
     QPointF normFromPos(const QPoint& pos) const;
 
@@ -41,6 +48,9 @@ private:
     int penWidth_{3};
     QString currentId_;
     QVector<QPointF> livePts_;
+    QVector<QPointF> pendingPts_;   // 还没发出的点
+    QPointF lastSentPt_;            // 上一批的最后一点，作为下一批简化的起点
+    QTimer flushTimer_;
     QString targetKey_;
     quint64 seq_{1};
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <QtCore>
+#include <QtNetwork>
+#include <functional>
+
+// 鉴权/工单/知识库服务（行分隔 JSON，端口 5555）的异步客户端
+// - 一条长连接，首次请求时自动连上，断开后下次请求再连；连接建立前的请求先排队
+// - 每个请求带自增 "req_id"（与业务字段 "id" 分开），服务端原样带回，多个请求可以同时在途，应答按 req_id 交付
+//   （旧服务端不回 req_id 时按发送顺序对应）
+// - 结果通过回调或 replied 信号交付，失败（连不上、断开、超时）也以 {"ok":false,"msg":...} 交付
+// - 服务端主动推送的行带 "event"、不带 req_id，经 pushed 信号交付，不占用在途请求
+class ApiClient : public QObject {
+    Q_OBJECT
+public:
+    using Callback = std::function<void(const QJsonObject&)>;
+
+    explicit ApiClient(QObject* parent=nullptr);
+
+    // 登录、工单页共用的默认实例
+    static ApiClient* instance();
+
+    // 地址变化时断开旧连接，在途请求按失败交付
+    void setServer(const QString& host, quint16 port);
+
+    // ctx 非空时随 ctx 销毁自动作废回调；返回请求 id
+    quint64 call(const QJsonObject& req, QObject* ctx = nullptr, Callback cb = Callback(), int msTimeout = 5000);
+    // 列表流式返回：服务端分块发多行应答，每块回调一次，"more" 为 false 的那块是最后一块；
+    // 超时按相邻两块的间隔计
+    quint64 stream(const QJsonObject& req, QObject* ctx, Callback cb, int msTimeout = 5000);
+    void cancel(quint64 id);
+    int inFlight() const { return pending_.size(); }
+
+signals:
+    void replied(quint64 id, QJsonObject reply);
+    void pushed(QJsonObject event);
+    void connectionLost();   // 已建立的连接断开；服务端的订阅随连接失效
+
+private slots:
+    void onConnected();
+    void onReadyRead();
+    void onDisconnected();
+    void onError(QAbstractSocket::SocketError);
+    void onTick();
+
+private:
+    struct Pending {
+        QPointer<QObject> ctx;
+        bool   hasCtx = false;
+        Callback cb;
+        qint64 deadline = 0;
+        int    timeout = 0;
+        bool   stream = false;
+    };
+
+    quint64 send(const QJsonObject& req, QObject* ctx, Callback cb, int msTimeout, bool stream);
+    void ensureConnected();
+    void finish(quint64 id, const QJsonObject& reply);
+    void failAll(const QString& msg);
+
+    QTcpSocket sock_;
+    QByteArray buf_;
+    QByteArray queued_;              // 连接建立前待发的请求行
+    QString host_ = QStringLiteral("127.0.0.1");
+    quint16 port_ = 5555;
+
+    quint64 nextId_ = 1;
+    QMap<quint64, Pending> pending_; // id 递增，即发送顺序
+    QTimer tick_;                    // 超时检查
+    QElapsedTimer clock_;
+};
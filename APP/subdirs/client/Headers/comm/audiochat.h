@@ -3,6 +3,32 @@
 #include <QtMultimedia>
 #include "clientconn.h"
 #include "protocol.h"
+#include "jitterbuffer.h"
+#include "audioring.h"
+#include "audiodsp.h"
+#include "audiocodec.h"
+
+class AudioChat;
+
+// 输出设备拉流：设备需要数据时回调 AudioChat::renderFrame，按帧切片交付
+// 注意：不同后端可能在音频线程里调用 readData，因此混音侧只读原子量和无锁队列
+class AudioPullDevice : public QIODevice {
+public:
+    AudioPullDevice(AudioChat* chat, int frameBytes, QObject* parent = nullptr);
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return frameBytes_ * 4 + QIODevice::bytesAvailable(); }
+
+protected:
+    qint64 readData(char* data, qint64 maxlen) override;
+    qint64 writeData(const char*, qint64) override { return -1; }
+
+private:
+    AudioChat* chat_;
+    QByteArray frame_;   // 预分配的输出帧
+    int frameBytes_;
+    int pos_;
+};
 
 class AudioChat : public QObject {
     Q_OBJECT
@@ -14,15 +40,22 @@ public:
     void setEnabled(bool on);
     bool isEnabled() const { return enabled_; }
 
-    void setPlaybackGain(float g) { playbackGain_ = qBound(0.0f, g, 2.0f); }
+    void setPlaybackGain(float g);
     float playbackGain() const { return playbackGain_; }
 
     void setMicGain(float g) { micGain_ = qBound(0.0f, g, 2.0f); }
     float micGain() const { return micGain_; }
 
-    void setPeerGain(const QString& sender, float g) { peerGain_[sender] = qBound(0.0f, g, 2.0f); }
-    float peerGain(const QString& sender) const { return peerGain_.value(sender, 1.0f); }
-    void dropPeer(const QString& sender) { rxQueues_.remove(sender); peerGain_.remove(sender); }
+    // 单路音量只作用于逐路转发的远端；服务端混音（MCU）时所有人合成一路 "__mix__"，
+    // 无法再分人调节，此时 setPeerGain 不生效，界面应以 mixMode() 判断并禁用单路音量
+    static const QString kMixSender;
+    void setPeerGain(const QString& sender, float g);
+    float peerGain(const QString& sender) const;
+    bool mixMode() const { return slotOf_.contains(kMixSender); }
+    void dropPeer(const QString& sender);
+
+    // 房间成员表只由主窗口的 RoomRoster 维护，成员变化后整表推过来（含自己也无妨）
+    void setMembers(const QStringList& members);
 
 public slots:
     void onPacket(Packet p);
@@ -31,24 +64,44 @@ signals:
     void micStateChanged(bool on);
 
 private:
-    static constexpr int   kSampleRate      = 8000;
+    friend class AudioPullDevice;
+
+    static constexpr int   kSampleRate      = 16000; // 采集/混音/播放统一用宽带
+    static constexpr int   kNarrowRate      = 8000;  // µ-law 线路采样率
     static constexpr int   kChannels        = 1;
     static constexpr int   kFrameMs         = 20;
     static constexpr int   kFrameSamples    = kSampleRate * kFrameMs / 1000;
     static constexpr int   kPcmBytesPerFrm  = kFrameSamples * 2;
-    static constexpr int   kUlawBytesPerFrm = kFrameSamples;
-    static constexpr int   kMaxQueueFrames  = 50;
+    static constexpr int   kOutBufferFrames = 4;   // 输出设备缓冲帧数（控制播放端时延）
+    static constexpr int   kMaxPeers        = 16;  // 同时混音的远端上限
+    static constexpr int   kCnIntervalMs    = 400; // 静音期间舒适噪声标记的发送间隔
+
+    static_assert(kFrameSamples <= AudioRing::kMaxSamples, "frame exceeds ring slot");
 
-    static quint8  linearToUlaw(qint16 pcm);
-    static qint16  ulawToLinear(quint8 ul);
+    // 每个远端一个固定槽位：网络侧写 ring，混音侧读 ring 并驱动抖动缓冲
+    struct PeerSlot {
+        PeerSlot() : jb(kFrameSamples, kFrameMs) {}
+        QAtomicInt   inUse{0};                    // 网络侧占用标记
+        QAtomicInt   resetReq{0};                 // 网络侧请求混音侧清空（成员离开）
+        QAtomicInt   gainQ12{AudioDsp::kGainOne};
+        AudioRing    ring;
+        AudioCodec::WidebandDecoder dec;          // 仅网络侧访问
+        JitterBuffer jb;                          // 仅混音侧访问
+        AudioDsp::ComfortNoise cng;               // 仅混音侧访问
+        int          cnLevel = 0;                 // 仅混音侧访问：对端最近上报的噪声底，0 为不补噪声
+    };
 
     void startInput();
     void stopInput();
     void ensureOutput();
     void onMicReadyRead();
-    void mixTick();
+    void sendSilenceMarker(qint64 nowMs, int level);
+    void onCodecAnnounce(const QJsonObject& j);
+    void announceCodecs();
+    void updateSendCodec();
 
-    void shrinkQueueIfNeeded(QByteArray& q);
+    int  slotFor(const QString& sender, bool create);
+    void renderFrame(qint16* out);   // 混音侧：产出一帧（设备拉流时调用）
 
     ClientConn* conn_ = nullptr;
     QString roomId_;
@@ -58,13 +111,24 @@ private:
     QIODevice*    inDev_    = nullptr;
     QAudioFormat  inFmt_;
     QByteArray    inBuf_;
+    AudioDsp::VoiceDetector vad_;
+    bool          talking_  = false;         // 当前是否处于语音段（DTX 状态）
+    qint64        lastCnMs_ = 0;
+    AudioCodec::WidebandEncoder enc_;
+    QString       sendCodec_ = QStringLiteral("mulaw");
+    QSet<QString> members_;                  // 房间内其他成员
+    QStringList   announced_;                // 本次入会已广播的编码能力；不变就不重播，新人由服务端重放最近一次声明
+    QSet<QString> wbPeers_;                  // 已声明支持 adpcm16 的成员
     QAudioOutput* audioOut_ = nullptr;
-    QIODevice*    outDev_   = nullptr;
+    AudioPullDevice* pullDev_ = nullptr;
     QAudioFormat  outFmt_;
-    QTimer        mixTimer_;
-    QHash<QString, QByteArray> rxQueues_;
+    QElapsedTimer clock_;                    // 抖动估计用的本地单调时钟
+    PeerSlot      slots_[kMaxPeers];
+    QHash<QString, int> slotOf_;             // sender -> 槽位，仅网络侧（GUI 线程）访问
+    qint32        acc_[kFrameSamples];       // 混音累加缓冲（预分配）
+    qint16        peerFrame_[kFrameSamples];
+    QAtomicInt    masterQ12_{AudioDsp::kGainOne};
     bool  enabled_       = false;
     float playbackGain_  = 1.0f;
     float micGain_       = 1.0f;
-    QHash<QString, float> peerGain_;
 };
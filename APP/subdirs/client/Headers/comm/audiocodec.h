@@ -0,0 +1,71 @@
+#pragma once
+#include <QtCore>
+
+// 会议语音编解码（无外部依赖）
+// - mulaw  ：G.711 µ-law，8kHz，64 kbps
+// - adpcm16：16kHz 宽带，G.722 式 24 阶 QMF 分成高低两个子带，
+//            低带 4bit IMA ADPCM + 高带 2bit ADPCM，20ms 帧 126 字节（约 50 kbps）
+// QMF 滤波用 SSE2 / NEON 的乘加实现；ADPCM 本身是逐样本递推，保持标量
+namespace AudioCodec {
+
+constexpr int kMaxFrameSamples = 640;   // 16kHz 下最长 40ms
+
+// G.711 µ-law
+quint8 linearToUlaw(qint16 pcm);
+qint16 ulawToLinear(quint8 ul);
+
+// adpcm16 负载字节数（samples 为 16kHz 样本数）
+// 帧头 6 字节：低带预测值(2) + 低带步长索引(1) + 高带预测值(2) + 高带步长索引(1)
+// 帧头携带编码器状态，解码端逐帧重同步，丢包不会让后续帧跑偏
+int adpcmWbBytes(int samples);
+
+// 负载电平估计（平均幅度，按 16bit 线性量纲），供服务端做说话人检测，不需要完整解码
+int ulawLevel(const quint8* data, int len);
+int adpcmWbLevel(const quint8* data, int len);
+
+struct AdpcmState {
+    qint16 pred  = 0;
+    int    index = 0;
+};
+
+class WidebandEncoder {
+public:
+    WidebandEncoder();
+    void reset();
+
+    // 16kHz PCM -> adpcm16 负载，返回写入字节数；out 至少 adpcmWbBytes(n) 字节
+    int encodeAdpcm(const qint16* pcm, int n, quint8* out);
+
+    // 16kHz PCM -> 8kHz PCM（取 QMF 低带），返回 n/2；用于向只支持 µ-law 的对端发送
+    int toNarrow(const qint16* pcm, int n, qint16* out);
+
+private:
+    int split(const qint16* pcm, int n, bool wantHigh);
+
+    qint16     buf_[22 + kMaxFrameSamples];   // 前 22 个为上一帧尾部（QMF 历史）
+    qint16     low_[kMaxFrameSamples / 2];
+    qint16     high_[kMaxFrameSamples / 2];
+    AdpcmState lowSt_;
+    AdpcmState highSt_;
+};
+
+class WidebandDecoder {
+public:
+    WidebandDecoder();
+    void reset();
+
+    // adpcm16 负载 -> 16kHz PCM，返回样本数；格式不对返回 0
+    int decodeAdpcm(const quint8* data, int len, qint16* out, int maxOut);
+
+    // 8kHz PCM -> 16kHz PCM（低带送入 QMF 合成，高带置零），返回 2n
+    int fromNarrow(const qint16* pcm, int n, qint16* out, int maxOut);
+
+private:
+    void merge(int half, qint16* out);
+
+    qint16 buf_[22 + kMaxFrameSamples];
+    qint16 low_[kMaxFrameSamples / 2];
+    qint16 high_[kMaxFrameSamples / 2];
+};
+
+} // namespace AudioCodec
@@ -0,0 +1,53 @@
+#pragma once
+#include <QtCore>
+
+// 单生产者/单消费者无锁环形队列（定长帧，预分配）
+// 生产者：网络线程解码后写入；消费者：音频拉流回调读出
+class AudioRing {
+public:
+    static constexpr int kCapacity   = 32;   // 必须为 2 的幂
+    static constexpr int kMaxSamples = 640;  // 单帧最大样本数
+
+    enum FrameFlag : quint8 {
+        FlagTalkStart = 0x01,   // 语音段首帧
+        FlagSilence   = 0x02,   // 舒适噪声标记：无 PCM，level 为对端噪声底（0 表示不补噪声）
+    };
+
+    struct Frame {
+        quint8  flags = 0;
+        int     level = 0;
+        quint32 seq = 0;
+        qint64  ts = 0;
+        qint64  arrivalMs = 0;
+        int     samples = 0;
+        qint16  pcm[kMaxSamples];
+    };
+
+    AudioRing() = default;
+    AudioRing(const AudioRing&) = delete;
+    AudioRing& operator=(const AudioRing&) = delete;
+
+    // 生产者：取一个可写帧，写完后 commitWrite()；满时返回 nullptr（丢帧）
+    Frame* beginWrite() {
+        const quint32 h = head_.loadAcquire();
+        if (h - tail_.loadAcquire() >= quint32(kCapacity)) return nullptr;
+        return &frames_[h & (kCapacity - 1)];
+    }
+    void commitWrite() { head_.storeRelease(head_.loadAcquire() + 1); }
+
+    // 消费者：查看队首，处理完后 popFront()；空时返回 nullptr
+    const Frame* front() const {
+        const quint32 t = tail_.loadAcquire();
+        if (head_.loadAcquire() == t) return nullptr;
+        return &frames_[t & (kCapacity - 1)];
+    }
+    void popFront() { tail_.storeRelease(tail_.loadAcquire() + 1); }
+
+    // 消费者：丢弃全部未读帧
+    void drain() { tail_.storeRelease(head_.loadAcquire()); }
+
+private:
+    QAtomicInteger<quint32> head_{0};
+    QAtomicInteger<quint32> tail_{0};
+    Frame frames_[kCapacity];
+};
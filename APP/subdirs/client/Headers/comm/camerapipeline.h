@@ -0,0 +1,82 @@
+#pragma once
+#include <QtCore>
+#include <QtGui>
+#include <QtMultimedia>
+#include "videocodec.h"
+
+// 摄像头处理流水线：颜色转换、缩放、联播分层和 JPEG 编码都在工作线程完成
+// GUI 线程只负责投递探针帧（上一帧没处理完就丢弃），以及接收预览图和编码结果
+class CameraPipeline : public QObject {
+    Q_OBJECT
+public:
+    explicit CameraPipeline(QObject* parent=nullptr);
+    ~CameraPipeline();
+
+    // 发送参数：第 0 层尺寸、帧率、质量、联播层数；wanted/topLayer 来自服务端需求提示
+    void setParams(const QSize& sendSize, int fps, int jpegQuality, int layers);
+    void setDemand(bool wanted, int topLayer);
+    // 服务端转来的关键帧请求：该层下一帧编成关键帧
+    void requestKeyframe(int layer);
+
+    // GUI 线程调用
+    void submit(const QVideoFrame& frame);
+
+signals:
+    void previewReady(QImage img);
+    // 每层一个信号；同一帧的各层 ts 相同，top 为本帧编码的第一层
+    // codec 为写入包头的编码描述（条件补充编码的帧类型与关键帧号）
+    void layerEncoded(QByteArray data, QSize size, int layer, int layers, int top, qint64 ts, QJsonObject codec);
+
+private:
+    static constexpr int kPreviewFps = 15;
+
+    QThread worker_;
+    class CameraWorker* work_{nullptr};
+    QAtomicInt busy_{0};
+
+    QSize sendSize_{640, 480};
+    int   fps_{12};
+    int   layers_{1};
+    bool  wanted_{true};
+    int   topLayer_{0};
+    QElapsedTimer lastEncode_;
+    QElapsedTimer lastPreview_;
+};
+
+class CameraWorker : public QObject {
+    Q_OBJECT
+public:
+    explicit CameraWorker(QAtomicInt* busy) : busy_(busy) {}
+    void setParams(const QSize& sendSize, int jpegQuality, int layers, int topLayer) {
+        if (sendSize != sendSize_ || layers != layers_) {
+            for (auto& e : enc_) e.reset();
+        }
+        sendSize_ = sendSize; quality_ = jpegQuality; layers_ = layers; topLayer_ = topLayer;
+    }
+    // 停编后重新开编的层从关键帧开始：停编期间的参考帧接收端可能从没收到过
+    void setTopLayer(int topLayer) {
+        for (int l = qMax(0, topLayer); l < qMin(topLayer_, 3); ++l) enc_[l].reset();
+        topLayer_ = topLayer;
+    }
+    void forceKeyframe(int layer) { if (layer >= 0 && layer < 3) enc_[layer].reset(); }
+    void resetEncoders() { for (auto& e : enc_) e.reset(); }
+
+public slots:
+    void process(QVideoFrame frame, bool encode, bool preview);
+
+signals:
+    void previewReady(QImage img);
+    void layerEncoded(QByteArray data, QSize size, int layer, int layers, int top, qint64 ts, QJsonObject codec);
+
+private:
+    QImage convert(QVideoFrame& frame, const QSize& target);
+    void encodeLayers(QImage img);
+
+    VideoCodec::CrEncoder enc_[3];   // 每个联播层各自的关键帧参考
+
+    QAtomicInt* busy_;
+    QSize sendSize_{640, 480};
+    int   quality_{60};
+    int   layers_{1};
+    int   topLayer_{0};
+};
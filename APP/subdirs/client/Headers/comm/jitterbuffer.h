@@ -0,0 +1,84 @@
+#pragma once
+#include <QtCore>
+
+// 每个远端一份的自适应抖动缓冲
+// - 按 seq 直接定位到固定槽位：乱序包自动归位，重复/过期包丢弃
+// - 按 RFC3550 的到达间隔抖动估计动态调整目标深度（帧数）
+// - 丢包：重复上一帧并逐帧衰减（PLC）
+// - 积压超过目标：把相邻两帧交叉淡化压成一帧（加速）
+// - 即将欠载：在低能量帧上重复一帧（减速），彻底耗尽后重新预缓冲
+// - 对端 DTX 静音：放完已缓冲的帧后直接空闲，不计为欠载
+class JitterBuffer {
+public:
+    explicit JitterBuffer(int frameSamples = 160, int frameMs = 20);
+
+    void reset();
+
+    // 压入一帧已解码 PCM16；samples 不足一帧时补零，超出时截断
+    // ts 为发送端时间戳（ms），arrivalMs 为本地单调时钟（ms）
+    // talkStart 为发送端标记的语音段首帧；任何比已收最大 seq 更新的帧同样会结束静音状态
+    void push(quint32 seq, qint64 ts, const qint16* pcm, int samples, qint64 arrivalMs,
+              bool talkStart = false);
+
+    // 发送端进入静音（DTX）：放完已缓冲的帧后安静地停下，不计为欠载
+    void markSilence() { silence_ = true; }
+
+    // 取出一帧播放数据（总是写满 frameSamples 个样本）
+    // 返回 false 表示本帧无声（预缓冲中或已耗尽），out 已清零
+    bool pop(qint16* out);
+
+    int depthFrames() const;
+    int targetFrames() const { return target_; }
+    double jitterMs() const { return jitter_; }
+    bool isPlaying() const { return playing_; }
+
+private:
+    static constexpr int kSlots         = 64;  // 1.28s@20ms，足够覆盖乱序窗口
+    static constexpr int kMinTarget     = 2;
+    static constexpr int kMaxTarget     = 12;
+    static constexpr int kMaxConceal    = 5;   // 连续隐藏帧上限，超过后静音并重新预缓冲
+    static constexpr int kAdjustGap     = 5;   // 两次加速/减速之间至少间隔的帧数
+    static constexpr int kQuietAbsLevel = 300; // 平均幅度低于此值视为低能量帧
+
+    struct Slot {
+        quint32 seq = 0;
+        bool filled = false;
+        QVector<qint16> pcm;
+    };
+
+    Slot& slotFor(quint32 seq) { return slots_[int(seq % kSlots)]; }
+    bool takeFrame(quint32 seq, qint16* out);
+    void conceal(qint16* out);
+    void remember(const qint16* frame);
+    void updateTarget();
+    void goIdle();
+    int  bufferedCount() const;
+    quint32 lowestBufferedSeq() const;
+    static int meanAbs(const qint16* s, int n);
+
+    int frameSamples_;
+    int frameMs_;
+    QVector<Slot> slots_;
+
+    bool    playing_      = false;
+    bool    haveAny_      = false;
+    bool    started_      = false; // 已开播过：此后落后于播放点的包视为迟到
+    bool    silence_      = false; // 对端处于 DTX 静音段
+    quint32 nextSeq_      = 0;  // 下一帧应播放的 seq
+    quint32 maxSeq_       = 0;  // 已收到的最大 seq
+
+    // 抖动估计
+    bool    haveTransit_  = false;
+    qint64  lastTransit_  = 0;
+    double  jitter_       = 0.0;   // ms，平滑均值
+    double  jitterPeak_   = 0.0;   // ms，慢衰减峰值
+    int     target_       = kMinTarget;
+    int     underrunBoost_= 0;     // 欠载后临时提高的目标帧数
+
+    // 隐藏/时长调整
+    QVector<qint16> lastGood_;
+    bool    haveLast_     = false;
+    int     concealRun_   = 0;
+    int     sinceAdjust_  = 0;
+    int     goodRun_      = 0;
+};
@@ -1,24 +1,15 @@
 #pragma once
 #include <QtCore>
-#include <QtNetwork>
+#include "apiclient.h"
 
+// 知识库查询：请求经 ApiClient 的长连接异步发出，结果 {"ok":bool, ...} 按块交给回调，
+// 最后一块的 "more" 为 false
 class KbClient {
 public:
-    // 同步调用，返回 {"ok":bool, ...}
-    static QJsonObject call(const QHostAddress& host, quint16 port, const QJsonObject& req, int msTimeout = 3000);
+    static quint64 getRecordings(ApiClient* api, const QString& roomId,
+                                 QObject* ctx, ApiClient::Callback cb);
 
-    static QJsonObject getRecordings(const QHostAddress& host, quint16 port,
-                                     const QString& roomId = QString()) {
-        QJsonObject req{{"action","get_recordings"}};
-        if (!roomId.isEmpty()) req["room_id"] = roomId;
-        return call(host, port, req);
-    }
-
-    static QJsonObject getRecordingFiles(const QHostAddress& host, quint16 port,
-                                         int recordingId = 0, const QString& roomId = QString()) {
-        QJsonObject req{{"action","get_recording_files"}};
-        if (recordingId > 0) req["recording_id"] = recordingId;
-        if (!roomId.isEmpty()) req["room_id"] = roomId;
-        return call(host, port, req);
-    }
+    // recordingId > 0 按录制查；否则按房间查（roomId 为空时返回全部文件）
+    static quint64 getRecordingFiles(ApiClient* api, int recordingId, const QString& roomId,
+                                     QObject* ctx, ApiClient::Callback cb);
 };
@@ -2,11 +2,16 @@
 
 #include <QWidget>
 #include <QHostAddress>
+#include <QHash>
+#include <QVector>
+#include <QJsonObject>
 
 class QLineEdit;
 class QSpinBox;
 class QPushButton;
 class QTableWidget;
+class ApiClient;
+class QJsonArray;
 
 class KnowledgePanel : public QWidget
 {
@@ -35,8 +40,15 @@ private:
     QPushButton*  refreshBtn_{nullptr};
     QTableWidget* table_{nullptr};
 
+    // 知识库查询走自己的长连接（地址可在面板上改，不影响登录/工单用的默认连接）
+    ApiClient*    api_{nullptr};
+    quint64       refreshGen_{0};   // 只认最近一次刷新的应答
+    bool          busy_{false};
+    QHash<int, QVector<QJsonObject>> filesByRec_;   // 本次刷新已收到的文件，按 recording_id 归并
+
     // helpers
     void setBusy(bool on);
+    void appendRows(const QJsonArray& recordings);   // 追加一块录制对应的文件行
     void playFile(const QString& filePath) const;
     QString findFfplay() const;
 
@@ -13,8 +13,10 @@
 
 #include "annot.h"
 #include "clientconn.h"
+#include "roomroster.h"
 #include "audiochat.h"
 #include "screenshare.h"
+#include "camerapipeline.h"
 
 class AnnotCanvas;
 class QComboBox;
@@ -29,6 +31,7 @@ class QStackedWidget;
 class QToolButton;
 class QComboBox;        // 新增
 class UdpMediaClient;
+class VideoDecodePool;
 
 // [KB] 前向声明：避免在头文件里包含 knowledge_panel.h
 class KnowledgePanel;
@@ -77,6 +80,8 @@ private slots:
 
     void onToggleCamera();
     void onVideoFrame(const QVideoFrame &frame);
+    void onCameraLayer(QByteArray data, QSize size, int layer, int layers, int top, qint64 ts, QJsonObject codec);
+    void onFrameDecoded(QString sender, QString media, QImage img, quint64 gen);
 
     void onLocalScreenFrame(QImage img);
     void onToggleShare();
@@ -105,9 +110,7 @@ private:
     void configureCamera(QCamera* cam);
     void hookCameraLogs(QCamera* cam);
 
-    QImage makeImageFromFrame(const QVideoFrame &frame);
     void updateLocalPreview(const QImage& img);
-    void sendImage(const QImage& img);
 
     enum class ViewMode { Grid, Focus };
     ViewMode currentMode() const;
@@ -128,12 +131,19 @@ private:
 
     static QImage composeTileImage(const VideoTile* t, const QSize& target);
     void refreshTilePixmap(VideoTile* t);
+    QSize decodeTargetFor(const VideoTile* t) const;   // 远端帧的解码尺寸：焦点主画面要原图，其余按格子大小
     void togglePiP(VideoTile* t);
 
     void applyAdaptiveByMembers(int members);
 
     void applyShareQualityPreset();
 
+    // 向服务端声明当前想看的视频流（布局/窗口变化后防抖发送）
+    void scheduleSubscription();
+    void scheduleTileRender(VideoTile* t);   // 标脏，下一个显示刷新周期统一重绘
+    void renderDirtyTiles();
+    void sendSubscription();
+
 private:
     QLineEdit *edHost{};
     QLineEdit *edPort{};
@@ -162,11 +172,14 @@ private:
     QMap<QString, VideoTile*> remoteTiles_;
     const QString kLocalKey_ = QStringLiteral("__local__");
     QString mainKey_;
+    QString activeSpeaker_;
+    RoomRoster roster_;                       // 房间成员表，服务端只推增量
 
     ClientConn conn_;
 
     AudioChat*     audio_{nullptr};
     ScreenShare*   share_{nullptr};
+    CameraPipeline* camPipe_{nullptr};   // 摄像头转换/编码在其工作线程完成
     UdpMediaClient* udp_{nullptr};
 
     QCamera *camera_{nullptr};
@@ -175,10 +188,18 @@ private:
     int targetFps_{12};
     int jpegQuality_{60};
     QSize sendSize_{640, 480};
-    QElapsedTimer lastSend_;
+    int simLayers_{1};   // 摄像头联播层数：第 0 层为 sendSize_，之后每层边长减半
     QVideoFrame::PixelFormat lastLoggedFormat_{QVideoFrame::Format_Invalid};
 
-    QHash<QString, QImage> screenBack_;
+    VideoDecodePool* decodePool_ = nullptr;   // 远端摄像头/屏幕帧的后台解码
+
+    QTimer*       renderTimer_{nullptr};
+    QSet<QString> dirtyTiles_;         // 收到新帧还没重绘的格子（key），每格只留最新一张图
+    bool          mainDirty_{false};
+
+    QTimer*    subTimer_{nullptr};
+    QByteArray lastSubscription_;      // 上次发出的订阅内容，未变化时不重发
+    static constexpr int kSubscribeLastN = 9;
 
     // [KB] 新增：知识库面板（防止重复创建）
     QPointer<KnowledgePanel> kbPanel_;
@@ -0,0 +1,27 @@
+#pragma once
+#include <QtCore>
+
+// 房间成员表的客户端副本：服务端入会时给一次全量（event=snapshot，带 members 和 version），
+// 之后只广播 join/leave 增量，每条增量版本号加一
+// - 版本号正好接上：套用增量
+// - 版本号不新：重复或过期的消息，忽略
+// - 版本号跳了：中间有丢失，调用方应向服务端要一次全量（MSG_CONTROL kind=members）
+// 不带 version 的旧服务端每次都发全量 members，照旧整表替换
+class RoomRoster {
+public:
+    enum Result { Ignored, Applied, Gap };
+
+    Result apply(const QJsonObject& j);
+    void reset() { users_.clear(); version_ = 0; synced_ = false; }
+
+    QStringList members() const;   // 已排序
+    bool contains(const QString& u) const { return users_.contains(u); }
+    int count() const { return users_.size(); }
+    quint64 version() const { return version_; }
+    bool synced() const { return synced_; }
+
+private:
+    QSet<QString> users_;
+    quint64 version_ = 0;
+    bool synced_ = false;   // 收到过全量才能接增量
+};
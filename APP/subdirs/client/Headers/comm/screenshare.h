@@ -20,6 +20,9 @@ public:
 
     void setParams(const QSize& sendBaseSize, int baseFps, int jpegQuality);
 
+    // 服务端需求提示：没人在看时停掉抓屏和编码，恢复时先发关键帧
+    void setDemand(bool wanted);
+
 signals:
     void localFrameReady(QImage img);
 
@@ -45,6 +48,7 @@ private:
     class KeyEncoder* encoder_{nullptr};
     QAtomicInt keyBusy_{0};
     bool    enabled_{false};
+    bool    demand_{true};
     qint64  lastKeyMs_{0};
     int     keyIntervalMs_{1000};
     QImage  prevFrame_;
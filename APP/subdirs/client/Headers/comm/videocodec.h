@@ -0,0 +1,65 @@
+#pragma once
+#include <QtCore>
+#include <QtGui>
+
+// 摄像头条件补充编码（codec "cr"）
+// - 关键帧：整帧 JPEG，老客户端也能直接解
+// - 增量帧：与最近关键帧逐 16x16 宏块比较，平均差超过噪声门限的块拼成一张图集，整体一次 JPEG
+//   每个增量都只相对关键帧，中途丢掉任意增量（限帧率、积压丢包、切层）都不影响后续解码
+//
+// 增量负载 'CR01'（BigEndian）：
+// u32 magic, u32 keyId, u16 w, u16 h, u16 count, count x (u16 bx, u16 by), u32 jpegLen, [图集 JPEG]
+// 图集每行 kAtlasCols 块，按 count 顺序从左到右、从上到下排列
+namespace VideoCodec {
+
+constexpr int kBlock     = 16;
+constexpr int kAtlasCols = 16;
+
+// 写入视频包 json 的编码描述：codec/frame/key
+class CrEncoder {
+public:
+    void reset();
+
+    // 编码一帧 RGB32；返回 false 表示本帧无需发送（画面与上一个空增量相同且未到刷新时间）
+    bool encode(const QImage& img, int quality, qint64 nowMs, QByteArray* out, QJsonObject* info);
+
+private:
+    static constexpr int kKeyIntervalMs   = 3000;
+    static constexpr int kIdleRefreshMs   = 1000;   // 静止画面仍按此间隔发空增量，维持接收端在线状态
+    static constexpr int kNoiseMean       = 3;      // 每通道平均绝对差门限
+    static constexpr int kMaxDeltaPercent = 40;     // 变化块超过此比例直接发关键帧
+
+    QImage  key_;
+    quint32 keyId_ = 0;
+    qint64  keyMs_ = 0;
+    qint64  lastSentMs_ = 0;
+    bool    lastEmpty_ = false;
+};
+
+class CrDecoder {
+public:
+    void reset();
+
+    // 解一个 MSG_VIDEO_FRAME；没有 codec 字段时按整帧 JPEG 处理
+    // target 为显示区域尺寸，有效时关键帧与图集都按同一 2 的幂缩小解码；无效表示要原图
+    // 返回 false 表示暂时无法出图（缺关键帧或数据损坏）
+    bool decode(const QJsonObject& j, const QByteArray& bin, QImage* out, const QSize& target = QSize());
+
+private:
+    QImage     key_;        // 按 shift_ 缩小后的关键帧
+    QByteArray keyJpeg_;    // 关键帧原始数据：显示尺寸变化时按新比例重解
+    QSize      keySize_;    // 关键帧原始尺寸
+    int        shift_ = 0;
+    quint32    keyId_ = 0;
+    bool       haveKey_ = false;
+};
+
+constexpr int kMaxDecodeShift = 3;   // libjpeg 在 DCT 域最多缩到 1/8
+
+QByteArray encodeJpeg(const QImage& img, int quality);
+// target 有效时按 fitShift 选的比例在 DCT 域直接缩小解码，省掉整幅解码和后续平滑缩放
+QImage     decodeJpeg(const QByteArray& data, const QSize& target = QSize());
+// full 等比放进 target 后，还能缩小多少级（每级边长减半）而不低于显示尺寸
+int        fitShift(const QSize& full, const QSize& target);
+
+} // namespace VideoCodec
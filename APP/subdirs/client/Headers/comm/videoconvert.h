@@ -0,0 +1,31 @@
+#pragma once
+#include <QtCore>
+
+// 摄像头原始帧 -> RGB32（0xffRRGGBB）的转换内核（SSE2 / NEON / 标量三套实现，编译期选择）
+// BT.601 有限范围系数，6bit 定点；三套实现逐像素结果一致
+// 支持在转换的同时按 2^shift 做盒式缩小，不必先生成全尺寸 RGB 图
+namespace VideoConvert {
+
+enum class Layout { YUYV, UYVY, NV12, NV21, I420, YV12 };
+
+struct Planes {
+    Layout layout = Layout::YUYV;
+    int width = 0, height = 0;
+    const quint8* p0 = nullptr; int s0 = 0;   // 打包格式的数据 / 平面格式的 Y
+    const quint8* p1 = nullptr; int s1 = 0;   // NV12/NV21 的交错色度；I420 的 U；YV12 的 V
+    const quint8* p2 = nullptr; int s2 = 0;   // I420 的 V；YV12 的 U
+};
+
+constexpr int kMaxShift = 2;   // 最多缩小到 1/4
+constexpr int kMaxWidth = 4096;
+
+// 输出 (width >> shift) x (height >> shift)，dstStride 为字节数；参数不合法返回 false
+bool toRgb32(const Planes& src, int shift, quint32* dst, int dstStride);
+
+// 一行 YUV（u/v 为半宽）转 RGB32
+void yuvRowToRgb32(const quint8* y, const quint8* u, const quint8* v, quint32* dst, int width);
+
+// 2x2 盒式缩小：输出 (w/2) x (h/2)
+void halveRgb32(const quint32* src, int w, int h, int srcStride, quint32* dst, int dstStride);
+
+} // namespace VideoConvert
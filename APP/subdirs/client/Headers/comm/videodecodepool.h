@@ -0,0 +1,56 @@
+#pragma once
+#include <QtCore>
+#include <QtGui>
+#include "videocodec.h"
+
+// 远端视频解码池：JPEG 解码、条件补充增量和 DS01 屏幕增量都在工作线程完成
+// - 每个发送者的每路媒体一条通道，通道内严格按到达顺序解码，不同通道可并行
+// - 通道忙时新帧排队；独立帧（整帧 JPEG、关键帧）到来时丢掉排在前面的旧帧，
+//   条件补充增量只相对关键帧，新增量会顶掉排队中的旧增量；DS01 增量是累积的，只能依次套用
+// - 一批排队帧只把最后一张成图交回 GUI 线程
+class VideoDecodePool : public QObject {
+    Q_OBJECT
+public:
+    explicit VideoDecodePool(QObject* parent=nullptr);
+    ~VideoDecodePool();
+
+    // TCP 视频包：摄像头按条件补充编码解，屏幕按整帧 JPEG 解；target 见 VideoCodec::decodeJpeg
+    void submitPacket(const QString& sender, const QString& media, const QJsonObject& j,
+                      const QByteArray& bin, const QSize& target);
+    // UDP 屏幕：整帧 JPEG 会同步为增量背板，所以按原图解
+    void submitScreenJpeg(const QString& sender, const QByteArray& jpeg);
+    void submitScreenDelta(const QString& sender, const QByteArray& blob, int w, int h);
+
+    // 丢弃该发送者（media 为空表示全部媒体）的排队帧和解码状态，已在解的结果也不再交付
+    void removeSender(const QString& sender, const QString& media = QString());
+    void clear();
+
+    // 每条通道创建时分配一个代号；removeSender/clear 之后同名通道会换新代号。
+    // 排队信号可能在移除之后才送达 GUI 线程，接收方用它判断结果是否已过期
+    bool isCurrent(const QString& sender, const QString& media, quint64 gen) const;
+
+signals:
+    void frameDecoded(QString sender, QString media, QImage img, quint64 gen);
+
+private:
+    enum class Kind { Jpeg, UdpJpeg, Cr, Ds01 };
+    struct Job {
+        Kind        kind = Kind::Jpeg;
+        QJsonObject json;
+        QByteArray  bin;
+        QSize       target;
+        int         w = 0, h = 0;
+    };
+    struct Lane;
+    class Task;
+
+    void enqueue(const QString& sender, const QString& media, Job job);
+    void drain(const QSharedPointer<Lane>& lane);
+    static bool decode(Lane& lane, const Job& job, QImage* out);
+    static bool applyDs01(QImage& back, const QByteArray& blob, int w, int h);
+
+    QThreadPool pool_;
+    mutable QMutex mu_;
+    QHash<QString, QSharedPointer<Lane>> lanes_;   // sender + '\n' + media
+    quint64     nextGen_ = 0;                      // 由 mu_ 保护
+};
@@ -32,7 +32,6 @@ private slots:
     void onRoleChanged(int index); // 根据角色切换主题
 
 private:
-    bool sendRequest(const QJsonObject &obj, QJsonObject &reply, QString *errMsg = nullptr);
     QString selectedRole() const; // "expert" | "factory" | ""
     void applyRoleTheme(const QString& roleKey); // 应用主题（"expert"/"factory"/"none"）
     void installPasswordEye();                   // 安装“密码可见”按钮
@@ -0,0 +1,41 @@
+#ifndef ORDERFEED_H
+#define ORDERFEED_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QTimer>
+
+// 工单变更订阅：在默认连接上订阅 subscribe_orders，服务端在工单增删改提交后推送变更，
+// 每条带单调递增的 seq 和 prev（本连接上一条的 seq）。接不上时带 since 重新订阅补发缺口，
+// 服务端补不了时发 resync 让界面全量重载；断线后定时重连续订
+class OrderFeed : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OrderFeed(QObject* parent = nullptr);
+
+    void start(const QString& role, const QString& username);
+
+    // 变更是否落在当前筛选条件内（与 get_orders 的关键字/状态条件近似一致）
+    static bool matches(const QJsonObject& order, const QString& keyword, const QString& status);
+
+signals:
+    void changed(const QString& op, const QJsonObject& order);   // op: insert / update / delete
+    void resync();
+
+private:
+    static constexpr int kRetryMs = 3000;
+
+    void subscribe();
+    void onPushed(const QJsonObject& ev);
+
+    QString role_, user_;
+    qint64  seq_ = 0;       // 已应用的最后一个 seq
+    bool    synced_ = false;// seq_ 经服务端确认过，可作为续订位置（可能为 0：订阅时流水还空着）
+    bool    live_ = false;  // 订阅已生效
+    bool    first_ = true;  // 首次订阅前界面自己做了全量加载
+    quint64 req_ = 0;
+    QTimer  retry_;
+};
+
+#endif // ORDERFEED_H
@@ -0,0 +1,55 @@
+#ifndef ORDERPAGER_H
+#define ORDERPAGER_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QPair>
+#include <QPointer>
+#include <QVector>
+
+class QAbstractScrollArea;
+
+// 工单列表按需分页：先取一页，表格滚到接近底部时以上一页的 next（关键字检索按相关度排时
+// 还有 next_rank）作游标再取一页，
+// 表格还没填满可视区时自动接着取。换查询条件时作废在途的页
+class OrderPager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OrderPager(QObject* parent = nullptr);
+
+    void watch(QAbstractScrollArea* view);
+    void reset(const QJsonObject& query);
+    void fetchMore();
+    bool hasMore() const { return more_; }
+    // id 是否落在已取到的范围内（按 id 分页时各页 id 升序）；范围外的行留给后续的页。
+    // 按相关度分页时无法按 id 判断，取完全部页之前都算不在范围内
+    bool covers(int id) const { return !first_ && (!more_ || (!ranked_ && id <= next_)); }
+    // 有页请求在途时推送来的变更先攒着：服务端多个库线程，在途的页可能读自该变更提交前的快照，
+    // 先套用变更再被旧页盖掉就丢了。返回 true 表示已暂存，该页到达（或失败）后经 deferredChange 按序交回
+    bool defer(const QString& op, const QJsonObject& order);
+
+signals:
+    void pageArrived(const QJsonArray& rows, bool first);
+    void failed(const QString& msg);
+    void deferredChange(const QString& op, const QJsonObject& order);
+
+private:
+    static constexpr int kPageSize = 100;
+
+    void maybeFetch();
+    void releaseDeferred();
+
+    QJsonObject query_;
+    double  next_ = 0;
+    double  nextRank_ = 0;
+    bool    ranked_ = false;
+    bool    more_ = false;
+    bool    first_ = true;
+    quint64 req_ = 0;   // 在途的页请求
+    QVector<QPair<QString, QJsonObject>> deferred_;   // 在途期间收到的变更，按到达顺序
+    QPointer<QAbstractScrollArea> view_;
+};
+
+#endif // ORDERPAGER_H
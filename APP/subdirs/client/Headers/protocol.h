@@ -58,6 +58,7 @@ QByteArray buildPacket(quint16 type,
 bool drainPackets(QByteArray& buffer, QVector<Packet>& out);
 
 // 标注消息类型
+// bin: 点坐标，每点 u16 x, u16 y（BigEndian，归一化坐标乘 65535），见 AnnotModel::packPoints
 static const quint16 MSG_ANNOT = 1206;
 
 
@@ -31,7 +31,6 @@ private slots:
     void onRoleChanged(int index); // 注册界面角色切换主题
 
 private:
-    bool sendRequest(const QJsonObject &obj, QJsonObject &reply, QString *errMsg = nullptr);
     QString selectedRole() const; // "expert" | "factory" | ""
     void applyRoleTheme(const QString& roleKey); // 应用主题（"expert"/"factory"/"none"）
     void installPasswordEye();                   // 安装密码可见按钮（密码与确认密码）
@@ -1,18 +1,19 @@
 #include "client_expert.h"
 #include "ui_client_expert.h"
 
-#include <QTcpSocket>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QMessageBox>
 #include <QTimer>
 #include <QString>
-#include <QElapsedTimer>
 
 #include "comm/commwidget.h"
 #include "comm/devicepanel.h"
 #include "comm/knowledge_panel.h"
+#include "comm/apiclient.h"
+#include "orderpager.h"
+#include "orderfeed.h"
 
 // 与工程既有约定保持一致
 QString g_factoryUsername;
@@ -21,25 +22,6 @@ QString g_expertUsername;
 static const char*  SERVER_HOST = "127.0.0.1";
 static const quint16 SERVER_PORT = 5555;
 
-// 可靠读取“以换行分隔”的一条 JSON（带超时聚合，避免半包）
-static QJsonDocument readJsonLine(QTcpSocket& sock, int timeoutMs = 5000) {
-    QByteArray buf;
-    QElapsedTimer et; et.start();
-    while (et.elapsed() < timeoutMs) {
-        if (!sock.bytesAvailable())
-            sock.waitForReadyRead(qMax(1, timeoutMs - int(et.elapsed())));
-        buf += sock.readAll();
-        int nl = buf.indexOf('\n');
-        if (nl >= 0) {
-            QByteArray line = buf.left(nl);
-            if (!line.isEmpty() && line.endsWith('\r')) line.chop(1);
-            return QJsonDocument::fromJson(line);
-        }
-    }
-    // 超时也尝试解析（容错）
-    return QJsonDocument::fromJson(buf);
-}
-
 ClientExpert::ClientExpert(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::ClientExpert)
@@ -95,6 +77,20 @@ ClientExpert::ClientExpert(QWidget *parent) :
     ui->comboBoxStatus->addItem("已接受");
     ui->comboBoxStatus->addItem("已拒绝");
 
+    pager_ = new OrderPager(this);
+    pager_->watch(ui->tableOrders);
+    connect(pager_, &OrderPager::pageArrived, this, &ClientExpert::applyOrders);
+    connect(pager_, &OrderPager::deferredChange, this, &ClientExpert::applyOrderChange);
+    connect(pager_, &OrderPager::failed, this, [this](const QString& msg){
+        QMessageBox::warning(this, "提示", msg);
+    });
+
+    // 工单增删改由服务端推送，逐行更新；先订阅再加载，同一连接上按序处理，两者之间的变更不会漏
+    feed_ = new OrderFeed(this);
+    connect(feed_, &OrderFeed::changed, this, &ClientExpert::applyOrderChange);
+    connect(feed_, &OrderFeed::resync, this, &ClientExpert::refreshOrders);
+    feed_->start("expert", g_expertUsername);
+
     refreshOrders();
     updateTabEnabled();
 }
@@ -119,12 +115,6 @@ void ClientExpert::updateTabEnabled()
 
 void ClientExpert::refreshOrders()
 {
-    QTcpSocket sock;
-    sock.connectToHost(SERVER_HOST, SERVER_PORT);
-    if (!sock.waitForConnected(2000)) {
-        QMessageBox::warning(this, "提示", "无法连接服务器");
-        return;
-    }
     QJsonObject req{
         {"action", "get_orders"},
         {"role", "expert"},
@@ -135,18 +125,15 @@ void ClientExpert::refreshOrders()
     QString status = ui->comboBoxStatus->currentText();
     if (status != "全部") req["status"] = status;
 
-    sock.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
-    sock.flush();
-
-    QJsonDocument doc = readJsonLine(sock);
-    if (!doc.isObject() || !doc.object().value("ok").toBool()) {
-        QMessageBox::warning(this, "提示", "服务器响应异常");
-        return;
-    }
+    // 分页取：先到的一页先显示，其余随滚动再取；连续点刷新时旧查询作废
+    pager_->reset(req);
+}
 
-    orders.clear();
-    QJsonArray arr = doc.object().value("orders").toArray();
-    orders.reserve(arr.size());
+void ClientExpert::applyOrders(const QJsonArray& arr, bool first)
+{
+    if (first) orders.clear();
+    const int base = orders.size();
+    orders.reserve(base + arr.size());
     for (const QJsonValue& v : arr) {
         QJsonObject o = v.toObject();
         orders.append(OrderInfo{
@@ -158,23 +145,66 @@ void ClientExpert::refreshOrders()
     auto* tbl = ui->tableOrders;
     bool wasSorting = tbl->isSortingEnabled();
     tbl->setSortingEnabled(false);
-    tbl->clearContents();
-    tbl->setColumnCount(4);
-    tbl->setRowCount(0);
+    if (first) {
+        tbl->clearContents();
+        tbl->setColumnCount(4);
+        tbl->setRowCount(0);
 
-    QStringList headers{"工单号", "标题", "描述", "状态"};
-    tbl->setHorizontalHeaderLabels(headers);
+        QStringList headers{"工单号", "标题", "描述", "状态"};
+        tbl->setHorizontalHeaderLabels(headers);
+    }
 
+    // 只追加本页的行
     tbl->setRowCount(orders.size());
-    for (int i = 0; i < orders.size(); ++i) {
+    for (int i = base; i < orders.size(); ++i) {
         const auto& od = orders[i];
         tbl->setItem(i, 0, new QTableWidgetItem(QString::number(od.id)));
         tbl->setItem(i, 1, new QTableWidgetItem(od.title));
         tbl->setItem(i, 2, new QTableWidgetItem(od.desc));
         tbl->setItem(i, 3, new QTableWidgetItem(od.status));
     }
-    tbl->resizeColumnsToContents();
-    tbl->clearSelection();
+    if (first) {
+        tbl->resizeColumnsToContents();
+        tbl->clearSelection();
+    }
+    tbl->setSortingEnabled(wasSorting);
+}
+
+void ClientExpert::applyOrderChange(const QString& op, const QJsonObject& o)
+{
+    if (pager_->defer(op, o)) return;   // 等在途的页套用完再处理，免得被旧快照盖掉
+    const int id = o.value("id").toInt();
+    int row = -1;
+    for (int i = 0; i < orders.size(); ++i) {
+        if (orders[i].id == id) { row = i; break; }
+    }
+    // 不再符合当前筛选条件的按删除处理；分页还没取到的范围等后续页带上
+    const bool keep = op != "delete"
+        && OrderFeed::matches(o, ui->lineEditKeyword->text().trimmed(), ui->comboBoxStatus->currentText());
+    if (keep && row < 0 && !pager_->covers(id)) return;
+
+    auto* tbl = ui->tableOrders;
+    bool wasSorting = tbl->isSortingEnabled();
+    tbl->setSortingEnabled(false);
+    if (!keep) {
+        if (row >= 0) {
+            orders.remove(row);
+            tbl->removeRow(row);
+        }
+    } else {
+        const OrderInfo od{id, o.value("title").toString(), o.value("desc").toString(), o.value("status").toString()};
+        if (row < 0) {
+            row = orders.size();
+            orders.append(od);
+            tbl->insertRow(row);
+        } else {
+            orders[row] = od;
+        }
+        tbl->setItem(row, 0, new QTableWidgetItem(QString::number(od.id)));
+        tbl->setItem(row, 1, new QTableWidgetItem(od.title));
+        tbl->setItem(row, 2, new QTableWidgetItem(od.desc));
+        tbl->setItem(row, 3, new QTableWidgetItem(od.status));
+    }
     tbl->setSortingEnabled(wasSorting);
 }
 
@@ -206,9 +236,6 @@ void ClientExpert::on_btnAccept_clicked()
         commWidget_->mainWindow()->setJoinedContext(QStringLiteral("expert"), QString::number(id));
     }
     QMetaObject::invokeMethod(commWidget_->mainWindow(), "onJoin");
-
-    // 立即刷新
-    refreshOrders();
 }
 
 void ClientExpert::on_btnReject_clicked()
@@ -222,38 +249,26 @@ void ClientExpert::on_btnReject_clicked()
 
     sendUpdateOrder(id, "已拒绝");
     setJoinedOrder(false);
-
-    refreshOrders();
 }
 
 void ClientExpert::sendUpdateOrder(int orderId, const QString& status)
 {
-    QTcpSocket sock;
-    sock.connectToHost(SERVER_HOST, SERVER_PORT);
-    if (!sock.waitForConnected(2000)) {
-        QMessageBox::warning(this, "提示", "无法连接服务器");
-        return;
-    }
     QJsonObject req{
         {"action", "update_order"},
         {"id", orderId},
         {"status", status}
     };
-    sock.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
-    sock.flush();
-
-    QJsonDocument doc = readJsonLine(sock);
-    if (!doc.isObject() || !doc.object().value("ok").toBool()) {
-        QMessageBox::warning(this, "提示", "服务器响应异常");
-    }
+    // 状态变化由变更推送回到表格
+    ApiClient::instance()->call(req, this, [this](const QJsonObject& rep){
+        if (!rep.value("ok").toBool())
+            QMessageBox::warning(this, "提示", rep.value("msg").toString("服务器响应异常"));
+    });
 }
 
 void ClientExpert::on_tabChanged(int idx)
 {
     QWidget* page = ui->tabWidget->widget(idx);
-    if (idx == 0) {
-        refreshOrders();
-    } else if (page == ui->tabDevice) {
+    if (page == ui->tabDevice) {
         int row = ui->tableOrders->currentRow();
         if (row >= 0 && row < orders.size() && devicePanel_) {
             devicePanel_->setOrderContext(QString::number(orders[row].id));
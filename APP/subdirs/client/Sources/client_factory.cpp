@@ -1,7 +1,6 @@
 #include "client_factory.h"
 #include "ui_client_factory.h"
 
-#include <QTcpSocket>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -14,35 +13,19 @@
 #include <QLineEdit>
 #include <QTextEdit>
 #include <QDialogButtonBox>
-#include <QElapsedTimer>
 
 #include "comm/commwidget.h"
 #include "comm/devicepanel.h"
 #include "comm/knowledge_panel.h"
+#include "comm/apiclient.h"
+#include "orderpager.h"
+#include "orderfeed.h"
 
 static const char*  SERVER_HOST = "127.0.0.1";
 static const quint16 SERVER_PORT = 5555;
 
 extern QString g_factoryUsername;
 
-// 可靠读取“以换行分隔”的一条 JSON
-static QJsonDocument readJsonLine(QTcpSocket& sock, int timeoutMs = 5000) {
-    QByteArray buf;
-    QElapsedTimer et; et.start();
-    while (et.elapsed() < timeoutMs) {
-        if (!sock.bytesAvailable())
-            sock.waitForReadyRead(qMax(1, timeoutMs - int(et.elapsed())));
-        buf += sock.readAll();
-        int nl = buf.indexOf('\n');
-        if (nl >= 0) {
-            QByteArray line = buf.left(nl);
-            if (!line.isEmpty() && line.endsWith('\r')) line.chop(1);
-            return QJsonDocument::fromJson(line);
-        }
-    }
-    return QJsonDocument::fromJson(buf);
-}
-
 class NewOrderDialog : public QDialog {
 public:
     QLineEdit*  editTitle;
@@ -131,6 +114,20 @@ ClientFactory::ClientFactory(QWidget *parent) :
     connect(ui->btnRefreshOrderStatus, &QPushButton::clicked, this, &ClientFactory::refreshOrders);
     connect(ui->btnDeleteOrder, &QPushButton::clicked, this, &ClientFactory::on_btnDeleteOrder_clicked);
 
+    pager_ = new OrderPager(this);
+    pager_->watch(ui->tableOrders);
+    connect(pager_, &OrderPager::pageArrived, this, &ClientFactory::applyOrders);
+    connect(pager_, &OrderPager::deferredChange, this, &ClientFactory::applyOrderChange);
+    connect(pager_, &OrderPager::failed, this, [this](const QString& msg){
+        QMessageBox::warning(this, "提示", msg);
+    });
+
+    // 工单增删改由服务端推送，逐行更新；先订阅再加载，同一连接上按序处理，两者之间的变更不会漏
+    feed_ = new OrderFeed(this);
+    connect(feed_, &OrderFeed::changed, this, &ClientFactory::applyOrderChange);
+    connect(feed_, &OrderFeed::resync, this, &ClientFactory::refreshOrders);
+    feed_->start("factory", g_factoryUsername);
+
     refreshOrders();
     updateTabEnabled();
 }
@@ -158,12 +155,6 @@ void ClientFactory::ensureDeviceContextFromSelection()
 
 void ClientFactory::refreshOrders()
 {
-    QTcpSocket sock;
-    sock.connectToHost(SERVER_HOST, SERVER_PORT);
-    if (!sock.waitForConnected(2000)) {
-        QMessageBox::warning(this, "提示", "无法连接服务器");
-        return;
-    }
     QJsonObject req{
         {"action", "get_orders"},
         {"role", "factory"},
@@ -174,18 +165,15 @@ void ClientFactory::refreshOrders()
     QString status = ui->comboBoxStatus->currentText();
     if (status != "全部") req["status"] = status;
 
-    sock.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
-    sock.flush();
-
-    QJsonDocument doc = readJsonLine(sock);
-    if (!doc.isObject() || !doc.object().value("ok").toBool()) {
-        QMessageBox::warning(this, "提示", "服务器响应异常");
-        return;
-    }
+    // 分页取：先到的一页先显示，其余随滚动再取；连续点刷新时旧查询作废
+    pager_->reset(req);
+}
 
-    orders.clear();
-    QJsonArray arr = doc.object().value("orders").toArray();
-    orders.reserve(arr.size());
+void ClientFactory::applyOrders(const QJsonArray& arr, bool first)
+{
+    if (first) orders.clear();
+    const int base = orders.size();
+    orders.reserve(base + arr.size());
     for (const QJsonValue& v : arr) {
         QJsonObject o = v.toObject();
         orders.append(OrderInfo{
@@ -197,31 +185,74 @@ void ClientFactory::refreshOrders()
     auto* tbl = ui->tableOrders;
     bool wasSorting = tbl->isSortingEnabled();
     tbl->setSortingEnabled(false);
-    tbl->clearContents();
-    tbl->setColumnCount(4);
-    tbl->setRowCount(0);
+    if (first) {
+        tbl->clearContents();
+        tbl->setColumnCount(4);
+        tbl->setRowCount(0);
 
-    QStringList headers{"工单号", "标题", "描述", "状态"};
-    tbl->setHorizontalHeaderLabels(headers);
+        QStringList headers{"工单号", "标题", "描述", "状态"};
+        tbl->setHorizontalHeaderLabels(headers);
+    }
 
+    // 只追加本页的行
     tbl->setRowCount(orders.size());
-    for (int i = 0; i < orders.size(); ++i) {
+    for (int i = base; i < orders.size(); ++i) {
         const auto& od = orders[i];
         tbl->setItem(i, 0, new QTableWidgetItem(QString::number(od.id)));
         tbl->setItem(i, 1, new QTableWidgetItem(od.title));
         tbl->setItem(i, 2, new QTableWidgetItem(od.desc));
         tbl->setItem(i, 3, new QTableWidgetItem(od.status));
     }
-    tbl->resizeColumnsToContents();
-    tbl->clearSelection();
+    if (first) {
+        tbl->resizeColumnsToContents();
+        tbl->clearSelection();
+    }
     tbl->setSortingEnabled(wasSorting);
 
     // 如果当前就在“设备管理”页，刷新完工单后立即确保上下文（让曲线立刻出现）
-    if (ui->tabWidget->currentWidget() == ui->tabDevice) {
+    if (first && ui->tabWidget->currentWidget() == ui->tabDevice) {
         ensureDeviceContextFromSelection();
     }
 }
 
+void ClientFactory::applyOrderChange(const QString& op, const QJsonObject& o)
+{
+    if (pager_->defer(op, o)) return;   // 等在途的页套用完再处理，免得被旧快照盖掉
+    const int id = o.value("id").toInt();
+    int row = -1;
+    for (int i = 0; i < orders.size(); ++i) {
+        if (orders[i].id == id) { row = i; break; }
+    }
+    // 不再符合当前筛选条件的按删除处理；分页还没取到的范围等后续页带上
+    const bool keep = op != "delete"
+        && OrderFeed::matches(o, ui->lineEditKeyword->text().trimmed(), ui->comboBoxStatus->currentText());
+    if (keep && row < 0 && !pager_->covers(id)) return;
+
+    auto* tbl = ui->tableOrders;
+    bool wasSorting = tbl->isSortingEnabled();
+    tbl->setSortingEnabled(false);
+    if (!keep) {
+        if (row >= 0) {
+            orders.remove(row);
+            tbl->removeRow(row);
+        }
+    } else {
+        const OrderInfo od{id, o.value("title").toString(), o.value("desc").toString(), o.value("status").toString()};
+        if (row < 0) {
+            row = orders.size();
+            orders.append(od);
+            tbl->insertRow(row);
+        } else {
+            orders[row] = od;
+        }
+        tbl->setItem(row, 0, new QTableWidgetItem(QString::number(od.id)));
+        tbl->setItem(row, 1, new QTableWidgetItem(od.title));
+        tbl->setItem(row, 2, new QTableWidgetItem(od.desc));
+        tbl->setItem(row, 3, new QTableWidgetItem(od.status));
+    }
+    tbl->setSortingEnabled(wasSorting);
+}
+
 void ClientFactory::on_btnNewOrder_clicked()
 {
     NewOrderDialog dlg(this);
@@ -232,33 +263,23 @@ void ClientFactory::on_btnNewOrder_clicked()
             QMessageBox::warning(this, "提示", "工单标题不能为空");
             return;
         }
+        // 新工单由变更推送加进表格
         sendCreateOrder(title, desc);
-        // 服务端确认后立即刷新
-        refreshOrders();
     }
 }
 
 void ClientFactory::sendCreateOrder(const QString& title, const QString& desc)
 {
-    QTcpSocket sock;
-    sock.connectToHost(SERVER_HOST, SERVER_PORT);
-    if (!sock.waitForConnected(2000)) {
-        QMessageBox::warning(this, "提示", "无法连接服务器");
-        return;
-    }
     QJsonObject req{
         {"action", "new_order"},
         {"title", title},
         {"desc",  desc},
         {"factory_user", g_factoryUsername}
     };
-    sock.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
-    sock.flush();
-
-    QJsonDocument doc = readJsonLine(sock);
-    if (!doc.isObject() || !doc.object().value("ok").toBool()) {
-        QMessageBox::warning(this, "提示", "服务器响应异常");
-    }
+    ApiClient::instance()->call(req, this, [this](const QJsonObject& rep){
+        if (!rep.value("ok").toBool())
+            QMessageBox::warning(this, "提示", rep.value("msg").toString("服务器响应异常"));
+    });
 }
 
 void ClientFactory::on_btnDeleteOrder_clicked()
@@ -277,30 +298,17 @@ void ClientFactory::on_btnDeleteOrder_clicked()
         deletingOrder = false;
         return;
     }
-    QTcpSocket sock;
-    sock.connectToHost(SERVER_HOST, SERVER_PORT);
-    if (!sock.waitForConnected(2000)) {
-        QMessageBox::warning(this, "提示", "无法连接服务器");
-        deletingOrder = false;
-        return;
-    }
     QJsonObject req{
         {"action", "delete_order"},
         {"id", id},
         {"username", g_factoryUsername}
     };
-    sock.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
-    sock.flush();
-
-    QJsonDocument doc = readJsonLine(sock);
-    if (!doc.isObject() || !doc.object().value("ok").toBool()) {
-        QMessageBox::warning(this, "提示", "服务器响应异常");
+    ApiClient::instance()->call(req, this, [this](const QJsonObject& rep){
         deletingOrder = false;
-        return;
-    }
-
-    deletingOrder = false;
-    refreshOrders();
+        if (!rep.value("ok").toBool()) {
+            QMessageBox::warning(this, "提示", rep.value("msg").toString("服务器响应异常"));
+        }
+    });
 }
 
 void ClientFactory::updateTabEnabled()
@@ -313,9 +321,7 @@ void ClientFactory::updateTabEnabled()
 void ClientFactory::on_tabChanged(int idx)
 {
     QWidget* page = ui->tabWidget->widget(idx);
-    if (idx == 0) {
-        refreshOrders();
-    } else if (page == ui->tabDevice) {
+    if (page == ui->tabDevice) {
         ensureDeviceContextFromSelection();  // 兜底：进入设备页确保上下文
     } else if (page == ui->tabOther) {
         int row = ui->tableOrders->currentRow();
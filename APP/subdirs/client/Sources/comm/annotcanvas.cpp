@@ -9,6 +9,10 @@ AnnotCanvas::AnnotCanvas(QWidget* parent) : QWidget(parent)
     setAttribute(Qt::WA_TransparentForMouseEvents, true); // 默认不拦截鼠标（未开启绘制）
     setMouseTracking(true);
     hide();
+
+    flushTimer_.setSingleShot(true);
+    flushTimer_.setInterval(kFlushMs);
+    connect(&flushTimer_, &QTimer::timeout, this, &AnnotCanvas::flushPending);
 }
 
 void AnnotCanvas::setEnabledDrawing(bool on)
@@ -103,41 +107,85 @@ void AnnotCanvas::emitBegin(const QPointF& npt)
             tool_==AnnotModel::Text?"text":"pen"},
         {"color", color_.name(QColor::HexRgb)},
         {"width", penWidth_},
-        {"pts", QJsonArray{ QJsonArray{ npt.x(), npt.y() } }},
         {"target", targetKey_},
         {"ts", QDateTime::currentMSecsSinceEpoch()}
     };
-    emit annotateEvent(ev);
+    lastSentPt_ = npt;
+    pendingPts_.clear();
+    emit annotateEvent(ev, AnnotModel::packPoints({npt}));
 }
 
 void AnnotCanvas::emitUpdate(const QVector<QPointF>& npts)
 {
     if (currentId_.isEmpty() || npts.isEmpty()) return;
-    QJsonArray arr;
-    for (const auto& p : npts) arr.push_back(QJsonArray{ p.x(), p.y() });
     QJsonObject ev{
         {"op","update"},
         {"id", currentId_},
-        {"pts", arr},
         {"target", targetKey_},
         {"ts", QDateTime::currentMSecsSinceEpoch()}
     };
-    emit annotateEvent(ev);
+    lastSentPt_ = npts.last();
+    emit annotateEvent(ev, AnnotModel::packPoints(npts));
 }
 
 void AnnotCanvas::emitEnd()
 {
     if (currentId_.isEmpty()) return;
+    flushTimer_.stop();
+    flushPending();
     QJsonObject ev{
         {"op","end"},
         {"id", currentId_},
         {"target", targetKey_},
         {"ts", QDateTime::currentMSecsSinceEpoch()}
     };
-    emit annotateEvent(ev);
+    emit annotateEvent(ev, QByteArray());
     currentId_.clear();
 }
 
+// Ramer–Douglas–Peucker：保留首尾，去掉离弦距离不超过 tol 的中间点（坐标为像素）
+static void simplifyRdp(const QVector<QPointF>& pts, int first, int last, double tol, QVector<bool>& keep)
+{
+    if (last <= first + 1) return;
+    const QPointF a = pts[first], b = pts[last];
+    const QPointF ab = b - a;
+    const double len = std::hypot(ab.x(), ab.y());
+    double maxD = -1.0;
+    int idx = first;
+    for (int i = first + 1; i < last; ++i) {
+        const QPointF ap = pts[i] - a;
+        const double d = (len < 1e-9) ? std::hypot(ap.x(), ap.y())
+                                      : std::abs(ab.x() * ap.y() - ab.y() * ap.x()) / len;
+        if (d > maxD) { maxD = d; idx = i; }
+    }
+    if (maxD <= tol) return;
+    keep[idx] = true;
+    simplifyRdp(pts, first, idx, tol, keep);
+    simplifyRdp(pts, idx, last, tol, keep);
+}
+
+// 发出攒下的点：自由笔迹以上一批末点为起点做 RDP 简化，图形工具只需要最新的终点
+void AnnotCanvas::flushPending()
+{
+    if (currentId_.isEmpty() || pendingPts_.isEmpty()) return;
+    QVector<QPointF> out;
+    if (tool_ == AnnotModel::Pen) {
+        QVector<QPointF> px;
+        px.reserve(pendingPts_.size() + 1);
+        px << QPointF(lastSentPt_.x() * width(), lastSentPt_.y() * height());
+        for (const QPointF& n : pendingPts_) px << QPointF(n.x() * width(), n.y() * height());
+        QVector<bool> keep(px.size(), false);
+        keep.last() = true;
+        simplifyRdp(px, 0, px.size() - 1, kSimplifyPx, keep);
+        for (int i = 1; i < px.size(); ++i)
+            if (keep[i]) out << pendingPts_[i - 1];
+    } else {
+        out << pendingPts_.last();
+    }
+    pendingPts_.clear();
+    emitUpdate(out);
+}
+
 void AnnotCanvas::mousePressEvent(QMouseEvent* e)
 {
     if (!drawingEnabled_ || !model_ || targetKey_.isEmpty()) return;
@@ -157,14 +205,13 @@ void AnnotCanvas::mousePressEvent(QMouseEvent* e)
             {"tool","text"},
             {"color", color_.name(QColor::HexRgb)},
             {"width", penWidth_},
-            {"pts", QJsonArray{ QJsonArray{ np.x(), np.y() } }},
             {"text", t},
             {"target", targetKey_},
             {"ts", QDateTime::currentMSecsSinceEpoch()}
         };
-        emit annotateEvent(evBegin);
+        emit annotateEvent(evBegin, AnnotModel::packPoints({np}));
         QJsonObject evEnd{{"op","end"},{"id",id},{"target",targetKey_},{"ts",QDateTime::currentMSecsSinceEpoch()}};
-        emit annotateEvent(evEnd);
+        emit annotateEvent(evEnd, QByteArray());
         return;
     }
 
@@ -183,25 +230,16 @@ void AnnotCanvas::mouseMoveEvent(QMouseEvent* e)
     auto pix = [&](const QPointF& n){ return QPointF(n.x()*width(), n.y()*height()); };
 
     if (tool_ == AnnotModel::Pen) {
-        if (livePts_.isEmpty()) {
+        if (livePts_.isEmpty() || QLineF(pix(livePts_.last()), pix(np)).length() >= 2.0) {
             livePts_.push_back(np);
-            emitUpdate({np});
-        } else {
-            const qreal dist = QLineF(pix(livePts_.last()), pix(np)).length();
-            if (dist >= 2.0) {
-                livePts_.push_back(np);
-                emitUpdate({np});
-            }
+            pendingPts_.push_back(np);
         }
     } else {
-        if (livePts_.size() == 1) {
-            livePts_.push_back(np);
-            emitUpdate({np});
-        } else {
-            livePts_.last() = np;
-            emitUpdate({np});
-        }
+        if (livePts_.size() == 1) livePts_.push_back(np);
+        else                      livePts_.last() = np;
+        pendingPts_.push_back(np);
     }
+    if (!pendingPts_.isEmpty() && !flushTimer_.isActive()) flushTimer_.start();
     update();
 }
 
@@ -0,0 +1,170 @@
+#include "apiclient.h"
+
+ApiClient::ApiClient(QObject* parent) : QObject(parent)
+{
+    connect(&sock_, &QTcpSocket::connected,    this, &ApiClient::onConnected);
+    connect(&sock_, &QTcpSocket::readyRead,    this, &ApiClient::onReadyRead);
+    connect(&sock_, &QTcpSocket::disconnected, this, &ApiClient::onDisconnected);
+    connect(&sock_, SIGNAL(error(QAbstractSocket::SocketError)),
+            this,   SLOT(onError(QAbstractSocket::SocketError)));
+
+    tick_.setInterval(250);
+    connect(&tick_, &QTimer::timeout, this, &ApiClient::onTick);
+    clock_.start();
+}
+
+ApiClient* ApiClient::instance()
+{
+    static ApiClient* inst = new ApiClient(qApp);
+    return inst;
+}
+
+void ApiClient::setServer(const QString& host, quint16 port)
+{
+    const QString h = host.trimmed();
+    if (h == host_ && port == port_) return;
+    host_ = h;
+    port_ = port;
+    // 排队中的请求是发给旧地址的，一并作废
+    queued_.clear();
+    if (sock_.state() != QAbstractSocket::UnconnectedState) sock_.abort();
+    failAll(QStringLiteral("服务器地址已变更"));
+}
+
+quint64 ApiClient::call(const QJsonObject& req, QObject* ctx, Callback cb, int msTimeout)
+{
+    return send(req, ctx, std::move(cb), msTimeout, false);
+}
+
+quint64 ApiClient::stream(const QJsonObject& req, QObject* ctx, Callback cb, int msTimeout)
+{
+    return send(req, ctx, std::move(cb), msTimeout, true);
+}
+
+quint64 ApiClient::send(const QJsonObject& req, QObject* ctx, Callback cb, int msTimeout, bool stream)
+{
+    const quint64 id = nextId_++;
+    QJsonObject r = req;
+    r["req_id"] = double(id);
+    if (stream) r["stream"] = true;
+
+    Pending p;
+    p.ctx = ctx;
+    p.hasCtx = (ctx != nullptr);
+    p.cb = std::move(cb);
+    p.timeout = qMax(1, msTimeout);
+    p.deadline = clock_.elapsed() + p.timeout;
+    p.stream = stream;
+    pending_.insert(id, std::move(p));
+    if (!tick_.isActive()) tick_.start();
+
+    const QByteArray line = QJsonDocument(r).toJson(QJsonDocument::Compact) + '\n';
+    if (sock_.state() == QAbstractSocket::ConnectedState) {
+        sock_.write(line);
+    } else {
+        queued_ += line;
+        ensureConnected();
+    }
+    return id;
+}
+
+void ApiClient::cancel(quint64 id)
+{
+    // 仍保留占位，旧服务端按顺序对应时不会错位；应答到来时直接丢弃
+    auto it = pending_.find(id);
+    if (it == pending_.end()) return;
+    it->cb = Callback();
+    it->hasCtx = true;
+    it->ctx.clear();
+}
+
+void ApiClient::ensureConnected()
+{
+    if (sock_.state() == QAbstractSocket::UnconnectedState)
+        sock_.connectToHost(host_, port_);
+}
+
+void ApiClient::onConnected()
+{
+    if (!queued_.isEmpty()) {
+        sock_.write(queued_);
+        queued_.clear();
+    }
+}
+
+void ApiClient::onReadyRead()
+{
+    buf_.append(sock_.readAll());
+    int nl;
+    while ((nl = buf_.indexOf('\n')) >= 0) {
+        const QByteArray line = buf_.left(nl).trimmed();
+        buf_.remove(0, nl + 1);
+        if (line.isEmpty()) continue;
+
+        QJsonParseError pe{};
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &pe);
+        QJsonObject rep = doc.object();
+        if (pe.error != QJsonParseError::NoError || !doc.isObject())
+            rep = QJsonObject{{"ok", false}, {"msg", "bad json"}};
+
+        if (rep.contains("event")) { emit pushed(rep); continue; }
+        quint64 id = rep.contains("req_id") ? quint64(rep.value("req_id").toDouble()) : 0;
+        if (!id && !pending_.isEmpty()) id = pending_.firstKey();
+        rep.remove("req_id");
+        if (id) finish(id, rep);
+    }
+}
+
+void ApiClient::onDisconnected()
+{
+    buf_.clear();
+    failAll(QStringLiteral("与服务器的连接已断开"));
+    emit connectionLost();
+}
+
+void ApiClient::onError(QAbstractSocket::SocketError)
+{
+    // 连接阶段失败不会触发 disconnected
+    if (sock_.state() != QAbstractSocket::ConnectedState) {
+        queued_.clear();
+        failAll(QStringLiteral("服务器连接失败"));
+    }
+}
+
+void ApiClient::onTick()
+{
+    if (pending_.isEmpty()) { tick_.stop(); return; }
+    const qint64 now = clock_.elapsed();
+    QVector<quint64> expired;
+    for (auto it = pending_.cbegin(); it != pending_.cend(); ++it)
+        if (it->deadline <= now) expired << it.key();
+    for (quint64 id : expired)
+        finish(id, QJsonObject{{"ok", false}, {"msg", QStringLiteral("服务器无响应")}});
+}
+
+void ApiClient::finish(quint64 id, const QJsonObject& reply)
+{
+    auto it = pending_.find(id);
+    if (it == pending_.end()) return;   // 已超时或已失败
+    if (it->stream && reply.value("more").toBool()) {
+        // 流式的中间块：请求继续在途
+        it->deadline = clock_.elapsed() + it->timeout;
+        const Pending p = it.value();
+        emit replied(id, reply);
+        if (p.cb && (!p.hasCtx || p.ctx)) p.cb(reply);
+        return;
+    }
+    const Pending p = it.value();
+    pending_.erase(it);
+
+    emit replied(id, reply);
+    if (p.cb && (!p.hasCtx || p.ctx)) p.cb(reply);
+}
+
+void ApiClient::failAll(const QString& msg)
+{
+    // 先摘下当前在途的请求：回调里新发的请求属于下一次连接
+    const QList<quint64> ids = pending_.keys();
+    const QJsonObject rep{{"ok", false}, {"msg", msg}};
+    for (quint64 id : ids) finish(id, rep);
+}
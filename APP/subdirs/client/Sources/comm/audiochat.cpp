@@ -1,47 +1,74 @@
 #include "audiochat.h"
 
-static inline qint16 clamp16(int v) {
-    if (v > 32767) return 32767;
-    if (v < -32768) return -32768;
-    return static_cast<qint16>(v);
+const QString AudioChat::kMixSender = QStringLiteral("__mix__");   // 与服务端 AudioMixer::kMixSender 一致
+
+AudioChat::AudioChat(ClientConn* conn, QObject* parent)
+    : QObject(parent), conn_(conn)
+{
+    clock_.start();
+
+    // 确保输出设备可用（拉流模式，由设备时钟驱动混音）
+    ensureOutput();
 }
 
-// µ-law 实现（G.711）
-quint8 AudioChat::linearToUlaw(qint16 pcm) {
-    const int BIAS = 0x84;
-    const int CLIP = 32635;
-    int sign = (pcm >> 8) & 0x80;
-    if (sign) pcm = -pcm;
-    if (pcm > CLIP) pcm = CLIP;
-    pcm += BIAS;
-    int exponent = 7;
-    for (int expMask = 0x4000; (pcm & expMask) == 0 && exponent > 0; expMask >>= 1) {
-        --exponent;
+void AudioChat::setPlaybackGain(float g) {
+    playbackGain_ = qBound(0.0f, g, 2.0f);
+    masterQ12_.storeRelease(AudioDsp::gainToQ12(playbackGain_));
+}
+
+int AudioChat::slotFor(const QString& sender, bool create) {
+    auto it = slotOf_.constFind(sender);
+    if (it != slotOf_.constEnd()) return it.value();
+    if (!create) return -1;
+    for (int i = 0; i < kMaxPeers; ++i) {
+        PeerSlot& s = slots_[i];
+        if (s.inUse.loadAcquire() || s.resetReq.loadAcquire()) continue;
+        s.gainQ12.storeRelease(AudioDsp::kGainOne);
+        s.dec.reset();
+        s.inUse.storeRelease(1);
+        slotOf_.insert(sender, i);
+        return i;
     }
-    int mantissa = (pcm >> (exponent + 3)) & 0x0F;
-    return static_cast<quint8>(~(sign | (exponent << 4) | mantissa));
+    return -1; // 槽位已满：超出上限的远端不参与混音
 }
 
-qint16 AudioChat::ulawToLinear(quint8 u) {
-    u = ~u;
-    int t = ((u & 0x0F) << 3) + 0x84;
-    t <<= ((u & 0x70) >> 4);
-    return (u & 0x80) ? (0x84 - t) : (t - 0x84);
+void AudioChat::setPeerGain(const QString& sender, float g) {
+    if (sender == kMixSender) return;   // 混音流固定单位增益，整体音量走 setPlaybackGain
+    const int i = slotFor(sender, true);
+    if (i < 0) return;
+    slots_[i].gainQ12.storeRelease(AudioDsp::gainToQ12(qBound(0.0f, g, 2.0f)));
 }
 
-AudioChat::AudioChat(ClientConn* conn, QObject* parent)
-    : QObject(parent), conn_(conn)
-{
-    // 混音定时器：按帧长输出
-    mixTimer_.setInterval(kFrameMs);
-    connect(&mixTimer_, &QTimer::timeout, this, &AudioChat::mixTick);
-    mixTimer_.start();
+float AudioChat::peerGain(const QString& sender) const {
+    auto it = slotOf_.constFind(sender);
+    if (it == slotOf_.constEnd()) return 1.0f;
+    return slots_[it.value()].gainQ12.loadAcquire() / float(AudioDsp::kGainOne);
+}
 
-    // 确保输出设备可用
-    ensureOutput();
+void AudioChat::dropPeer(const QString& sender) {
+    auto it = slotOf_.find(sender);
+    if (it == slotOf_.end()) return;
+    PeerSlot& s = slots_[it.value()];
+    slotOf_.erase(it);
+    s.inUse.storeRelease(0);
+    if (pullDev_) {
+        s.resetReq.storeRelease(1);  // 交给混音侧清空，清空前槽位不会被复用
+    } else {
+        s.ring.drain();              // 没有输出设备就没有混音侧，直接清空
+        s.jb.reset();
+        s.cng.reset();
+        s.cnLevel = 0;
+    }
 }
 
 void AudioChat::setIdentity(const QString& roomId, const QString& sender) {
+    if (roomId != roomId_) {
+        // 换房间：能力表作废，等新房间的成员快照再协商
+        members_.clear();
+        wbPeers_.clear();
+        sendCodec_ = QStringLiteral("mulaw");
+    }
+    announced_.clear();   // 每次入会都要在首个成员快照后声明一次
     roomId_ = roomId;
     sender_ = sender;
 }
@@ -91,6 +118,10 @@ void AudioChat::stopInput() {
     audioIn_ = nullptr;
     inDev_ = nullptr;
     inBuf_.clear();
+    vad_.reset();
+    if (talking_ && !roomId_.isEmpty() && !sender_.isEmpty())
+        sendSilenceMarker(QDateTime::currentMSecsSinceEpoch(), 0); // 闭麦：对端按静音段收尾，不补噪声
+    talking_ = false;
 }
 
 void AudioChat::ensureOutput() {
@@ -111,11 +142,15 @@ void AudioChat::ensureOutput() {
         outFmt_.setCodec("audio/pcm");
     }
     audioOut_ = new QAudioOutput(devInfo, outFmt_, this);
-    audioOut_->setBufferSize(kPcmBytesPerFrm * 20);
-    outDev_ = audioOut_->start();
-    if (!outDev_) {
-        qWarning() << "AudioOutput start failed";
+    audioOut_->setBufferSize(kPcmBytesPerFrm * kOutBufferFrames);
+
+    pullDev_ = new AudioPullDevice(this, kPcmBytesPerFrm, this);
+    pullDev_->open(QIODevice::ReadOnly);
+    audioOut_->start(pullDev_);
+    if (audioOut_->error() != QAudio::NoError) {
+        qWarning() << "AudioOutput start failed" << audioOut_->error();
         delete audioOut_; audioOut_ = nullptr;
+        delete pullDev_;  pullDev_ = nullptr;
         return;
     }
 }
@@ -132,41 +167,63 @@ void AudioChat::onMicReadyRead() {
 
         // 应用本地麦克风增益并限幅（在编码前）
         qint16* s = reinterpret_cast<qint16*>(pcm.data());
-        if (micGain_ != 1.0f) {
-            for (int i = 0; i < kFrameSamples; ++i) {
-                int v = static_cast<int>(s[i] * micGain_);
-                s[i] = clamp16(v);
-            }
+        AudioDsp::applyGain(s, kFrameSamples, AudioDsp::gainToQ12(micGain_));
+
+        // DTX：静音段不发语音帧，只按间隔发舒适噪声标记
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        if (!vad_.process(s, kFrameSamples)) {
+            if (talking_ || now - lastCnMs_ >= kCnIntervalMs) sendSilenceMarker(now, vad_.noiseLevel());
+            talking_ = false;
+            continue;
         }
 
-        // PCM16 -> µ-law
-        QByteArray ulaw; ulaw.resize(kUlawBytesPerFrm);
-        for (int i = 0; i < kFrameSamples; ++i) {
-            ulaw[i] = static_cast<char>(linearToUlaw(s[i]));
+        // 编码：房间内全员支持时发宽带 ADPCM，否则降到 8kHz µ-law
+        QByteArray payload;
+        int sr = kSampleRate;
+        if (sendCodec_ == QLatin1String("adpcm16")) {
+            payload.resize(AudioCodec::adpcmWbBytes(kFrameSamples));
+            payload.resize(enc_.encodeAdpcm(s, kFrameSamples,
+                                            reinterpret_cast<quint8*>(payload.data())));
+        } else {
+            qint16 nb[kFrameSamples / 2];
+            const int n = enc_.toNarrow(s, kFrameSamples, nb);
+            payload.resize(n);
+            for (int i = 0; i < n; ++i) payload[i] = static_cast<char>(AudioCodec::linearToUlaw(nb[i]));
+            sr = kNarrowRate;
         }
 
         // 组包并发送
         QJsonObject j{
             {"roomId", roomId_},
             {"sender", sender_},
-            {"codec",  "mulaw"},
-            {"sr",     kSampleRate},
+            {"codec",  sendCodec_},
+            {"sr",     sr},
             {"ch",     kChannels},
             {"seq",    static_cast<int>(seq_++)},
-            {"ts",     QDateTime::currentMSecsSinceEpoch()}
+            {"ts",     now}
         };
-        if (conn_) conn_->send(MSG_AUDIO_FRAME, j, ulaw);
+        if (!talking_) j["m"] = 1; // 语音段首帧
+        talking_ = true;
+        if (conn_) conn_->send(MSG_AUDIO_FRAME, j, payload);
     }
 }
 
-void AudioChat::shrinkQueueIfNeeded(QByteArray& q) {
-    const int maxBytes = kMaxQueueFrames * kPcmBytesPerFrm;
-    if (q.size() > maxBytes) {
-        q.remove(0, q.size() - maxBytes);
-    }
+void AudioChat::sendSilenceMarker(qint64 nowMs, int level) {
+    lastCnMs_ = nowMs;
+    QJsonObject j{
+        {"roomId", roomId_},
+        {"sender", sender_},
+        {"codec",  "cn"},
+        {"sr",     kSampleRate},
+        {"ch",     kChannels},
+        {"level",  level},
+        {"ts",     nowMs}
+    };
+    if (conn_) conn_->send(MSG_AUDIO_FRAME, j, QByteArray());
 }
 
 void AudioChat::onPacket(Packet p) {
+    if (p.type == MSG_CONTROL)      { onCodecAnnounce(p.json); return; }
     if (p.type != MSG_AUDIO_FRAME) return;
 
     const QString roomId = p.json.value("roomId").toString();
@@ -176,71 +233,183 @@ void AudioChat::onPacket(Packet p) {
     if (!sender_.isEmpty() && sender == sender_) return;
 
     const QString codec = p.json.value("codec").toString("mulaw").toLower();
-    const int sr = p.json.value("sr").toInt(kSampleRate);
+    const int sr = p.json.value("sr").toInt(kNarrowRate);
     const int ch = p.json.value("ch").toInt(kChannels);
-    if (sr != kSampleRate || ch != kChannels) {
+    if ((sr != kSampleRate && sr != kNarrowRate) || ch != kChannels) {
         return;
     }
 
-    QByteArray& q = rxQueues_[sender];
-    if (codec == "mulaw") {
-        const int n = p.bin.size();
-        if (n <= 0) return;
-        const uchar* u = reinterpret_cast<const uchar*>(p.bin.constData());
-        QByteArray pcm; pcm.resize(n * 2);
-        qint16* d = reinterpret_cast<qint16*>(pcm.data());
-        for (int i = 0; i < n; ++i) d[i] = ulawToLinear(u[i]);
-        q.append(pcm);
-    } else if (codec == "pcm16") {
-        q.append(p.bin);
-    } else {
+    // 旧版本发送端都带 seq/ts；缺失时退化为按到达顺序编号
+    const quint32 seq = p.json.contains("seq") ? quint32(p.json.value("seq").toDouble())
+                                               : quint32(clock_.elapsed() / kFrameMs);
+    const qint64  ts  = p.json.contains("ts")  ? qint64(p.json.value("ts").toDouble())
+                                               : clock_.elapsed();
+
+    if (codec != "mulaw" && codec != "pcm16" && codec != "adpcm16" && codec != "cn") return;
+    if (codec == "adpcm16" && !wbPeers_.contains(sender)) {
+        wbPeers_.insert(sender);   // 能发就能收：视同已声明
+        updateSendCodec();
+    }
+    const int slot = slotFor(sender, true);
+    if (slot < 0) return;
+    PeerSlot& ps = slots_[slot];
+
+    // 直接解码进该远端的无锁队列；混音侧来不及消费时丢帧
+    AudioRing::Frame* f = ps.ring.beginWrite();
+    if (!f) return;
+    if (codec == "cn") {
+        f->flags = AudioRing::FlagSilence;
+        f->level = qMax(0, p.json.value("level").toInt());
+        f->samples = 0;
+        ps.ring.commitWrite();
         return;
     }
-    shrinkQueueIfNeeded(q);
-}
-
-void AudioChat::mixTick() {
-    if (!audioOut_ || !outDev_) return;
-
-    int bytesFree = audioOut_->bytesFree();
-    while (bytesFree >= kPcmBytesPerFrm) {
-        QByteArray out; out.resize(kPcmBytesPerFrm);
-        qint16* outS = reinterpret_cast<qint16*>(out.data());
-        for (int i = 0; i < kFrameSamples; ++i) outS[i] = 0;
-
-        // 逐路读取并按各自增益混合
-        for (auto it = rxQueues_.begin(); it != rxQueues_.end(); ++it) {
-            const QString sender = it.key();
-            const float   gain   = peerGain_.value(sender, 1.0f);
-            QByteArray&   q      = it.value();
-
-            if (q.size() >= kPcmBytesPerFrm) {
-                const qint16* inS = reinterpret_cast<const qint16*>(q.constData());
-                if (gain == 1.0f) {
-                    for (int i = 0; i < kFrameSamples; ++i) {
-                        int acc = static_cast<int>(outS[i]) + static_cast<int>(inS[i]);
-                        outS[i] = clamp16(acc);
-                    }
-                } else if (gain > 0.0f) {
-                    for (int i = 0; i < kFrameSamples; ++i) {
-                        int acc = static_cast<int>(outS[i]) + static_cast<int>(inS[i] * gain);
-                        outS[i] = clamp16(acc);
-                    }
-                } // gain==0 静音：跳过
-                q.remove(0, kPcmBytesPerFrm);
-            }
+
+    // 统一解码到 16kHz；窄带流经该远端的 QMF 合成升采样
+    int n = 0;
+    if (codec == "adpcm16") {
+        n = ps.dec.decodeAdpcm(reinterpret_cast<const quint8*>(p.bin.constData()), p.bin.size(),
+                               f->pcm, kFrameSamples);
+    } else {
+        qint16 nb[kFrameSamples];
+        int m = 0;
+        if (codec == "mulaw") {
+            m = qMin(p.bin.size(), int(kFrameSamples));
+            const uchar* u = reinterpret_cast<const uchar*>(p.bin.constData());
+            for (int i = 0; i < m; ++i) nb[i] = AudioCodec::ulawToLinear(u[i]);
+        } else {
+            m = qMin(p.bin.size() / 2, int(kFrameSamples));
+            memcpy(nb, p.bin.constData(), size_t(m) * 2);
+        }
+        if (sr == kNarrowRate) {
+            n = ps.dec.fromNarrow(nb, m, f->pcm, kFrameSamples);
+        } else {
+            n = m;
+            memcpy(f->pcm, nb, size_t(n) * 2);
         }
+    }
+    if (n <= 0) return;
+
+    f->flags = p.json.value("m").toInt() ? quint8(AudioRing::FlagTalkStart) : quint8(0);
+    f->seq = seq;
+    f->ts = ts;
+    f->arrivalMs = clock_.elapsed();
+    f->samples = n;
+    ps.ring.commitWrite();
+}
+
+void AudioChat::setMembers(const QStringList& members) {
+    QSet<QString> now = QSet<QString>::fromList(members);
+    now.remove(sender_);
+    for (auto it = wbPeers_.begin(); it != wbPeers_.end(); ) {
+        if (!now.contains(*it)) it = wbPeers_.erase(it);
+        else ++it;
+    }
+    members_ = now;
+
+    // 入会后广播一次本端能力；之后进来的人由服务端房间状态重放这条声明，不必每次成员变化都重发
+    announceCodecs();
+    updateSendCodec();
+}
+
+void AudioChat::onCodecAnnounce(const QJsonObject& j) {
+    if (j.value("kind").toString() != "audio") return;
+    const QString sender = j.value("sender").toString();
+    if (sender.isEmpty() || sender == sender_) return;
+    if (!roomId_.isEmpty() && j.value("roomId").toString() != roomId_) return;
+
+    bool wb = false;
+    for (auto v : j.value("codecs").toArray()) wb |= (v.toString() == "adpcm16");
+    if (wb) wbPeers_.insert(sender);
+    else    wbPeers_.remove(sender);
+    updateSendCodec();
+}
+
+void AudioChat::announceCodecs() {
+    if (!conn_ || roomId_.isEmpty() || sender_.isEmpty()) return;
+    const QStringList codecs{QStringLiteral("adpcm16"), QStringLiteral("mulaw")};
+    if (codecs == announced_) return;
+    QJsonObject j{
+        {"roomId", roomId_},
+        {"sender", sender_},
+        {"kind",   "audio"},
+        {"codecs", QJsonArray::fromStringList(codecs)},
+        {"ts",     QDateTime::currentMSecsSinceEpoch()}
+    };
+    conn_->send(MSG_CONTROL, j);
+    announced_ = codecs;
+}
 
-        // 应用整体播放增益
-        if (playbackGain_ != 1.0f) {
-            for (int i = 0; i < kFrameSamples; ++i) {
-                int v = static_cast<int>(outS[i] * playbackGain_);
-                outS[i] = clamp16(v);
+void AudioChat::updateSendCodec() {
+    // 旧客户端不会声明能力，只要房间里有一个未声明的成员就退回 µ-law
+    bool wb = true;
+    for (const QString& m : members_) {
+        if (!wbPeers_.contains(m)) { wb = false; break; }
+    }
+    const QString codec = wb ? QStringLiteral("adpcm16") : QStringLiteral("mulaw");
+    if (codec == sendCodec_) return;
+    qInfo() << "[audio] send codec" << sendCodec_ << "->" << codec;
+    sendCodec_ = codec;
+}
+
+void AudioChat::renderFrame(qint16* out) {
+    memset(acc_, 0, sizeof(acc_));
+    const qint32 master = masterQ12_.loadAcquire();
+
+    for (PeerSlot& s : slots_) {
+        if (s.resetReq.loadAcquire()) {
+            s.ring.drain();
+            s.jb.reset();
+            s.cng.reset();
+            s.cnLevel = 0;
+            s.resetReq.storeRelease(0);
+            continue;
+        }
+        if (!s.inUse.loadAcquire()) continue;
+
+        // 把网络侧新到的帧搬进抖动缓冲
+        while (const AudioRing::Frame* f = s.ring.front()) {
+            if (f->flags & AudioRing::FlagSilence) {
+                s.cnLevel = f->level;
+                s.jb.markSilence();
+            } else {
+                s.jb.push(f->seq, f->ts, f->pcm, f->samples, f->arrivalMs,
+                          f->flags & AudioRing::FlagTalkStart);
             }
+            s.ring.popFront();
+        }
+        if (!s.jb.pop(peerFrame_)) {
+            // 对端静音（或新语音段预缓冲中）：用舒适噪声填补，避免“死寂”感
+            if (s.cnLevel <= 0) continue;
+            s.cng.generate(peerFrame_, kFrameSamples, s.cnLevel);
         }
 
-        qint64 w = outDev_->write(out);
-        if (w <= 0) break;
-        bytesFree -= static_cast<int>(w);
+        // 每路增益与总增益合并为一个 Q12 系数，int32 累加，最后统一饱和
+        const qint32 g = (s.gainQ12.loadAcquire() * master) >> 12;
+        AudioDsp::mixAccumulate(acc_, peerFrame_, kFrameSamples, g);
+    }
+    AudioDsp::packSaturate(out, acc_, kFrameSamples);
+}
+
+// ========== AudioPullDevice ==========
+AudioPullDevice::AudioPullDevice(AudioChat* chat, int frameBytes, QObject* parent)
+    : QIODevice(parent), chat_(chat), frameBytes_(frameBytes), pos_(frameBytes)
+{
+    frame_.resize(frameBytes_);
+}
+
+qint64 AudioPullDevice::readData(char* data, qint64 maxlen) {
+    // 设备要多少给多少：不足一帧的部分留到下次，保证帧边界与混音节拍一致
+    qint64 written = 0;
+    while (written < maxlen) {
+        if (pos_ >= frameBytes_) {
+            chat_->renderFrame(reinterpret_cast<qint16*>(frame_.data()));
+            pos_ = 0;
+        }
+        const int n = int(qMin<qint64>(frameBytes_ - pos_, maxlen - written));
+        memcpy(data + written, frame_.constData() + pos_, size_t(n));
+        pos_ += n;
+        written += n;
     }
+    return written;
 }
@@ -0,0 +1,296 @@
+#include "audiocodec.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define AUDIOCODEC_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define AUDIOCODEC_NEON 1
+#endif
+
+namespace AudioCodec {
+
+static inline qint16 sat16(qint32 v) {
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return qint16(v);
+}
+
+// ========== G.711 µ-law ==========
+quint8 linearToUlaw(qint16 pcm) {
+    const int BIAS = 0x84;
+    const int CLIP = 32635;
+    int v = pcm;
+    int sign = (v >> 8) & 0x80;
+    if (sign) v = -v;
+    if (v > CLIP) v = CLIP;
+    v += BIAS;
+    int exponent = 7;
+    for (int expMask = 0x4000; (v & expMask) == 0 && exponent > 0; expMask >>= 1) {
+        --exponent;
+    }
+    int mantissa = (v >> (exponent + 3)) & 0x0F;
+    return static_cast<quint8>(~(sign | (exponent << 4) | mantissa));
+}
+
+qint16 ulawToLinear(quint8 u) {
+    u = ~u;
+    int t = ((u & 0x0F) << 3) + 0x84;
+    t <<= ((u & 0x70) >> 4);
+    return (u & 0x80) ? (0x84 - t) : (t - 0x84);
+}
+
+// ========== QMF ==========
+// G.722 的 24 阶 QMF 系数，按 24 个连续输入样本展开：
+//   低带 = Σ x[k]*kLowTaps[k]  >> 14，高带 = Σ x[k]*kHighTaps[k] >> 14
+//   合成：偶数输出 = Σ x[k]*kOddTaps[k] >> 11，奇数输出 = Σ x[k]*kEvenTaps[k] >> 11
+alignas(16) static const qint16 kLowTaps[24] = {
+       3,  -11,  -11,   53,   12, -156,   32,  362, -210, -805,  951, 3876,
+    3876,  951, -805, -210,  362,   32, -156,   12,   53,  -11,  -11,    3 };
+alignas(16) static const qint16 kHighTaps[24] = {
+      -3,  -11,   11,   53,  -12, -156,  -32,  362,  210, -805, -951, 3876,
+   -3876,  951,  805, -210, -362,   32,  156,   12,  -53,  -11,   11,    3 };
+alignas(16) static const qint16 kEvenTaps[24] = {
+       3,    0,  -11,    0,   12,    0,   32,    0, -210,    0,  951,    0,
+    3876,    0, -805,    0,  362,    0, -156,    0,   53,    0,  -11,    0 };
+alignas(16) static const qint16 kOddTaps[24] = {
+       0,  -11,    0,   53,    0, -156,    0,  362,    0, -805,    0, 3876,
+       0,  951,    0, -210,    0,   32,    0,   12,    0,  -11,    0,    3 };
+
+static inline qint32 dot24(const qint16* x, const qint16* taps)
+{
+#if defined(AUDIOCODEC_SSE2)
+    const __m128i* t = reinterpret_cast<const __m128i*>(taps);
+    __m128i s = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)), t[0]);
+    s = _mm_add_epi32(s, _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + 8)),  t[1]));
+    s = _mm_add_epi32(s, _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + 16)), t[2]));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+#elif defined(AUDIOCODEC_NEON)
+    int32x4_t s = vmull_s16(vld1_s16(x), vld1_s16(taps));
+    for (int k = 4; k < 24; k += 4) s = vmlal_s16(s, vld1_s16(x + k), vld1_s16(taps + k));
+    int32x2_t r = vadd_s32(vget_low_s32(s), vget_high_s32(s));
+    return vget_lane_s32(vpadd_s32(r, r), 0);
+#else
+    qint32 s = 0;
+    for (int k = 0; k < 24; ++k) s += qint32(x[k]) * taps[k];
+    return s;
+#endif
+}
+
+// ========== ADPCM ==========
+static const qint16 kStepTable[89] = {
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767 };
+static const int kIndex4[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static inline int clampIndex(int i) { return i < 0 ? 0 : (i > 88 ? 88 : i); }
+
+// 低带：标准 IMA 4bit（符号 + 3bit 幅度）
+static inline quint8 encode4(AdpcmState& st, qint16 x)
+{
+    int step = kStepTable[st.index];
+    int diff = int(x) - st.pred;
+    quint8 code = 0;
+    if (diff < 0) { code = 8; diff = -diff; }
+    int dq = step >> 3;
+    if (diff >= step) { code |= 4; diff -= step; dq += step; }
+    step >>= 1;
+    if (diff >= step) { code |= 2; diff -= step; dq += step; }
+    step >>= 1;
+    if (diff >= step) { code |= 1; dq += step; }
+    st.pred = sat16((code & 8) ? st.pred - dq : st.pred + dq);
+    st.index = clampIndex(st.index + kIndex4[code & 7]);
+    return code;
+}
+
+static inline qint16 decode4(AdpcmState& st, quint8 code)
+{
+    const int step = kStepTable[st.index];
+    int dq = step >> 3;
+    if (code & 4) dq += step;
+    if (code & 2) dq += step >> 1;
+    if (code & 1) dq += step >> 2;
+    st.pred = sat16((code & 8) ? st.pred - dq : st.pred + dq);
+    st.index = clampIndex(st.index + kIndex4[code & 7]);
+    return st.pred;
+}
+
+// 高带：2bit（符号 + 1bit 幅度），重建电平 0.5/1.5 倍步长
+static inline quint8 encode2(AdpcmState& st, qint16 x)
+{
+    const int step = kStepTable[st.index];
+    int diff = int(x) - st.pred;
+    quint8 code = 0;
+    if (diff < 0) { code = 2; diff = -diff; }
+    int dq = step >> 1;
+    if (diff >= step) { code |= 1; dq += step; }
+    st.pred = sat16((code & 2) ? st.pred - dq : st.pred + dq);
+    st.index = clampIndex(st.index + ((code & 1) ? 2 : -1));
+    return code;
+}
+
+static inline qint16 decode2(AdpcmState& st, quint8 code)
+{
+    const int step = kStepTable[st.index];
+    int dq = step >> 1;
+    if (code & 1) dq += step;
+    st.pred = sat16((code & 2) ? st.pred - dq : st.pred + dq);
+    st.index = clampIndex(st.index + ((code & 1) ? 2 : -1));
+    return st.pred;
+}
+
+static inline void putState(quint8* p, const AdpcmState& st) {
+    p[0] = quint8(quint16(st.pred) & 0xFF);
+    p[1] = quint8(quint16(st.pred) >> 8);
+    p[2] = quint8(st.index);
+}
+
+static inline AdpcmState getState(const quint8* p) {
+    AdpcmState st;
+    st.pred  = qint16(quint16(p[0]) | (quint16(p[1]) << 8));
+    st.index = clampIndex(p[2]);
+    return st;
+}
+
+int adpcmWbBytes(int samples)
+{
+    const int half = samples / 2;
+    return 6 + (half + 1) / 2 + (half + 3) / 4;
+}
+
+int ulawLevel(const quint8* data, int len)
+{
+    if (!data || len <= 0) return 0;
+    qint64 acc = 0;
+    for (int i = 0; i < len; ++i) acc += qAbs(int(ulawToLinear(data[i])));
+    return int(acc / len);
+}
+
+int adpcmWbLevel(const quint8* data, int len)
+{
+    // 只解低带（语音能量主要在 4kHz 以下），QMF 低带增益 0.5，结果乘 2 还原
+    if (!data || len < 6) return 0;
+    const int half = (((len - 6) * 4) / 3) & ~3;
+    if (half <= 0) return 0;
+    AdpcmState st = getState(data);
+    const quint8* lo = data + 6;
+    qint64 acc = 0;
+    for (int j = 0; j < half; ++j)
+        acc += qAbs(int(decode4(st, quint8((lo[j >> 1] >> ((j & 1) * 4)) & 0x0F))));
+    return int(acc * 2 / half);
+}
+
+// ========== 编码端 ==========
+WidebandEncoder::WidebandEncoder() { reset(); }
+
+void WidebandEncoder::reset()
+{
+    memset(buf_, 0, sizeof(buf_));
+    lowSt_ = AdpcmState();
+    highSt_ = AdpcmState();
+}
+
+int WidebandEncoder::split(const qint16* pcm, int n, bool wantHigh)
+{
+    n = qMin(n, kMaxFrameSamples) & ~1;
+    memcpy(buf_ + 22, pcm, size_t(n) * sizeof(qint16));
+    const int half = n / 2;
+    for (int j = 0; j < half; ++j) {
+        const qint16* w = buf_ + 2 * j;
+        low_[j] = sat16(dot24(w, kLowTaps) >> 14);
+        if (wantHigh) high_[j] = sat16(dot24(w, kHighTaps) >> 14);
+    }
+    memmove(buf_, buf_ + n, 22 * sizeof(qint16));
+    return half;
+}
+
+int WidebandEncoder::encodeAdpcm(const qint16* pcm, int n, quint8* out)
+{
+    const int half = split(pcm, n, true);
+    putState(out, lowSt_);
+    putState(out + 3, highSt_);
+
+    quint8* lo = out + 6;
+    quint8* hi = lo + (half + 1) / 2;
+    memset(lo, 0, size_t((half + 1) / 2 + (half + 3) / 4));
+    for (int j = 0; j < half; ++j) {
+        lo[j >> 1] |= quint8(encode4(lowSt_, low_[j]) << ((j & 1) * 4));
+        hi[j >> 2] |= quint8(encode2(highSt_, high_[j]) << ((j & 3) * 2));
+    }
+    return adpcmWbBytes(half * 2);
+}
+
+int WidebandEncoder::toNarrow(const qint16* pcm, int n, qint16* out)
+{
+    // QMF 低带直流增益为 0.5，补回 6dB
+    const int half = split(pcm, n, false);
+    for (int j = 0; j < half; ++j) out[j] = sat16(qint32(low_[j]) * 2);
+    return half;
+}
+
+// ========== 解码端 ==========
+WidebandDecoder::WidebandDecoder() { reset(); }
+
+void WidebandDecoder::reset()
+{
+    memset(buf_, 0, sizeof(buf_));
+}
+
+void WidebandDecoder::merge(int half, qint16* out)
+{
+    qint16* x = buf_ + 22;
+    for (int j = 0; j < half; ++j) {
+        x[2 * j]     = sat16(qint32(low_[j]) + high_[j]);
+        x[2 * j + 1] = sat16(qint32(low_[j]) - high_[j]);
+    }
+    for (int j = 0; j < half; ++j) {
+        const qint16* w = buf_ + 2 * j;
+        out[2 * j]     = sat16(dot24(w, kOddTaps)  >> 11);
+        out[2 * j + 1] = sat16(dot24(w, kEvenTaps) >> 11);
+    }
+    memmove(buf_, buf_ + 2 * half, 22 * sizeof(qint16));
+}
+
+int WidebandDecoder::decodeAdpcm(const quint8* data, int len, qint16* out, int maxOut)
+{
+    if (!data || len < 6) return 0;
+    // 由负载长度反推样本数（帧长总是 4 的倍数个 16kHz 样本）
+    int half = ((len - 6) * 4) / 3;
+    half &= ~3;
+    half = qMin(half, qMin(maxOut, kMaxFrameSamples) / 2);
+    if (half <= 0 || adpcmWbBytes(half * 2) > len) return 0;
+
+    AdpcmState lowSt  = getState(data);
+    AdpcmState highSt = getState(data + 3);
+    const quint8* lo = data + 6;
+    const quint8* hi = lo + (half + 1) / 2;
+    for (int j = 0; j < half; ++j) {
+        low_[j]  = decode4(lowSt,  quint8((lo[j >> 1] >> ((j & 1) * 4)) & 0x0F));
+        high_[j] = decode2(highSt, quint8((hi[j >> 2] >> ((j & 3) * 2)) & 0x03));
+    }
+    merge(half, out);
+    return half * 2;
+}
+
+int WidebandDecoder::fromNarrow(const qint16* pcm, int n, qint16* out, int maxOut)
+{
+    const int half = qMin(n, qMin(maxOut, kMaxFrameSamples) / 2);
+    for (int j = 0; j < half; ++j) {
+        low_[j]  = qint16(pcm[j] >> 1);   // 与 toNarrow 对称：合成端低带增益为 2
+        high_[j] = 0;
+    }
+    merge(half, out);
+    return half * 2;
+}
+
+} // namespace AudioCodec
@@ -0,0 +1,166 @@
+#include "camerapipeline.h"
+#include "videoconvert.h"
+
+CameraPipeline::CameraPipeline(QObject* parent) : QObject(parent)
+{
+    qRegisterMetaType<QVideoFrame>("QVideoFrame");
+
+    work_ = new CameraWorker(&busy_);
+    work_->moveToThread(&worker_);
+    connect(&worker_, &QThread::finished, work_, &QObject::deleteLater);
+    connect(work_, &CameraWorker::previewReady, this, &CameraPipeline::previewReady, Qt::QueuedConnection);
+    connect(work_, &CameraWorker::layerEncoded, this, &CameraPipeline::layerEncoded, Qt::QueuedConnection);
+    worker_.setObjectName("camera-pipeline");
+    worker_.start();
+}
+
+CameraPipeline::~CameraPipeline()
+{
+    worker_.quit();
+    worker_.wait();
+}
+
+void CameraPipeline::setParams(const QSize& sendSize, int fps, int jpegQuality, int layers)
+{
+    sendSize_ = sendSize;
+    fps_      = qMax(1, fps);
+    layers_   = qBound(1, layers, 3);
+    const QSize s = sendSize_;
+    const int l = layers_, t = topLayer_;
+    CameraWorker* w = work_;
+    QMetaObject::invokeMethod(work_, [w, s, jpegQuality, l, t]{ w->setParams(s, jpegQuality, l, t); }, Qt::QueuedConnection);
+}
+
+void CameraPipeline::setDemand(bool wanted, int topLayer)
+{
+    const bool resumed = wanted && !wanted_;
+    wanted_   = wanted;
+    topLayer_ = qMax(0, topLayer);
+    const int t = topLayer_;
+    CameraWorker* w = work_;
+    QMetaObject::invokeMethod(work_, [w, t, resumed]{
+        if (resumed) w->resetEncoders();   // 停发过一段，全部层从关键帧重新开始
+        w->setTopLayer(t);
+    }, Qt::QueuedConnection);
+}
+
+void CameraPipeline::requestKeyframe(int layer)
+{
+    CameraWorker* w = work_;
+    QMetaObject::invokeMethod(work_, [w, layer]{ w->forceKeyframe(layer); }, Qt::QueuedConnection);
+}
+
+void CameraPipeline::submit(const QVideoFrame& frame)
+{
+    if (!frame.isValid()) return;
+    const bool encode  = wanted_ && (!lastEncode_.isValid() || lastEncode_.elapsed() >= 1000 / fps_);
+    const bool preview = !lastPreview_.isValid() || lastPreview_.elapsed() >= 1000 / kPreviewFps;
+    if (!encode && !preview) return;
+
+    // 工作线程还在处理上一帧：直接丢，不排队
+    if (!busy_.testAndSetAcquire(0, 1)) return;
+    if (encode)  lastEncode_.restart();
+    if (preview) lastPreview_.restart();
+    QMetaObject::invokeMethod(work_, "process", Qt::QueuedConnection,
+                              Q_ARG(QVideoFrame, frame), Q_ARG(bool, encode), Q_ARG(bool, preview));
+}
+
+/* ---------- 工作线程 ---------- */
+void CameraWorker::process(QVideoFrame frame, bool encode, bool preview)
+{
+    QImage img = convert(frame, sendSize_);
+    if (!img.isNull()) {
+        if (preview) emit previewReady(img);
+        if (encode) encodeLayers(img);
+    }
+    busy_->storeRelease(0);
+}
+
+void CameraWorker::encodeLayers(QImage img)
+{
+    const int top = qBound(0, topLayer_, layers_ - 1);
+    const qint64 ts = QDateTime::currentMSecsSinceEpoch();
+
+    // 每层边长减半；top 之前的层没人要，只缩不编
+    for (int layer = 0; layer < layers_; ++layer) {
+        if (layer > 0) {
+            QImage half(qMax(1, img.width() / 2), qMax(1, img.height() / 2), QImage::Format_RGB32);
+            VideoConvert::halveRgb32(reinterpret_cast<const quint32*>(img.constBits()), img.width(), img.height(),
+                                     img.bytesPerLine(), reinterpret_cast<quint32*>(half.bits()), half.bytesPerLine());
+            img = half;
+        }
+        if (layer < top) continue;
+
+        QByteArray data;
+        QJsonObject codec;
+        if (!enc_[layer].encode(img, qMax(30, quality_ - 5 * layer), ts, &data, &codec)) continue;
+        emit layerEncoded(data, img.size(), layer, layers_, top, ts, codec);
+    }
+}
+
+static bool layoutOf(QVideoFrame::PixelFormat fmt, VideoConvert::Layout* out)
+{
+    using L = VideoConvert::Layout;
+    switch (fmt) {
+    case QVideoFrame::Format_YUYV: *out = L::YUYV; return true;
+    case QVideoFrame::Format_UYVY: *out = L::UYVY; return true;
+    case QVideoFrame::Format_NV12: *out = L::NV12; return true;
+    case QVideoFrame::Format_NV21: *out = L::NV21; return true;
+    case QVideoFrame::Format_YUV420P: *out = L::I420; return true;
+    case QVideoFrame::Format_YV12: *out = L::YV12; return true;
+    default: return false;
+    }
+}
+
+// 映射原始帧并转成 RGB32，尺寸按 target 等比适配
+// YUV 格式先在转换时按 2 的幂缩小到不小于目标的尺寸，剩余的小比例缩放再交给 QImage
+QImage CameraWorker::convert(QVideoFrame& frame, const QSize& target)
+{
+    if (!frame.map(QAbstractVideoBuffer::ReadOnly)) return QImage();
+
+    const QVideoFrame::PixelFormat fmt = frame.pixelFormat();
+    const int W = frame.width(), H = frame.height();
+    const QSize fit = QSize(W, H).scaled(target, Qt::KeepAspectRatio);
+    QImage out;
+
+    VideoConvert::Layout layout;
+    const QImage::Format imf = QVideoFrame::imageFormatFromPixelFormat(fmt);
+    if (imf != QImage::Format_Invalid) {
+        const QImage wrap(frame.bits(), W, H, frame.bytesPerLine(), imf);
+        out = (fit == wrap.size()) ? wrap.copy()
+                                   : wrap.scaled(fit, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    } else if (layoutOf(fmt, &layout)) {
+        VideoConvert::Planes p;
+        p.layout = layout;
+        p.width = W; p.height = H;
+        p.p0 = frame.bits(); p.s0 = frame.bytesPerLine();
+        if (layout != VideoConvert::Layout::YUYV && layout != VideoConvert::Layout::UYVY) {
+            // 有的后端把整帧报成一个平面，按标准排布推算色度平面位置
+            const bool semi = (layout == VideoConvert::Layout::NV12 || layout == VideoConvert::Layout::NV21);
+            if (frame.planeCount() >= (semi ? 2 : 3)) {
+                p.p1 = frame.bits(1); p.s1 = frame.bytesPerLine(1);
+                if (!semi) { p.p2 = frame.bits(2); p.s2 = frame.bytesPerLine(2); }
+            } else {
+                p.p1 = p.p0 + size_t(p.s0) * H;
+                p.s1 = semi ? p.s0 : p.s0 / 2;
+                if (!semi) { p.p2 = p.p1 + size_t(p.s1) * (H / 2); p.s2 = p.s1; }
+            }
+        }
+
+        int shift = 0;
+        while (shift < VideoConvert::kMaxShift
+               && (W >> (shift + 1)) >= fit.width() && (H >> (shift + 1)) >= fit.height()) ++shift;
+        out = QImage(W >> shift, H >> shift, QImage::Format_RGB32);
+        if (!VideoConvert::toRgb32(p, shift, reinterpret_cast<quint32*>(out.bits()), out.bytesPerLine()))
+            out = QImage();
+    } else {
+        static QVideoFrame::PixelFormat warned = QVideoFrame::Format_Invalid;
+        if (warned != fmt) { warned = fmt; qWarning() << "[camera] unsupported pixel format" << fmt; }
+    }
+    frame.unmap();
+
+    if (out.isNull()) return out;
+    if (out.size() != fit) out = out.scaled(fit, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    if (out.depth() != 32) out = out.convertToFormat(QImage::Format_RGB32);
+    return out;
+}
@@ -0,0 +1,251 @@
+#include "jitterbuffer.h"
+#include <cmath>
+#include <cstring>
+
+JitterBuffer::JitterBuffer(int frameSamples, int frameMs)
+    : frameSamples_(qMax(1, frameSamples)), frameMs_(qMax(1, frameMs))
+{
+    // 槽位与隐藏帧一次性分配，播放过程中不再申请内存
+    slots_.resize(kSlots);
+    for (Slot& s : slots_) s.pcm.resize(frameSamples_);
+    lastGood_.resize(frameSamples_);
+}
+
+void JitterBuffer::reset()
+{
+    for (Slot& s : slots_) s.filled = false;
+    playing_ = false;
+    haveAny_ = false;
+    started_ = false;
+    silence_ = false;
+    nextSeq_ = maxSeq_ = 0;
+    haveTransit_ = false;
+    haveLast_ = false;
+    concealRun_ = 0;
+    sinceAdjust_ = 0;
+    goodRun_ = 0;
+}
+
+int JitterBuffer::meanAbs(const qint16* s, int n)
+{
+    if (n <= 0) return 0;
+    qint64 acc = 0;
+    for (int i = 0; i < n; ++i) acc += qAbs(int(s[i]));
+    return int(acc / n);
+}
+
+void JitterBuffer::updateTarget()
+{
+    // 平滑抖动的 3 倍与峰值的一半取大，再加一帧余量
+    const double est = qMax(jitter_ * 3.0, jitterPeak_ * 0.5);
+    const int frames = int(std::ceil(est / frameMs_)) + 1 + underrunBoost_;
+    target_ = qBound(int(kMinTarget), frames, int(kMaxTarget));
+}
+
+int JitterBuffer::depthFrames() const
+{
+    if (!haveAny_) return 0;
+    const qint32 d = qint32(maxSeq_ - nextSeq_) + 1;
+    return d > 0 ? d : 0;
+}
+
+int JitterBuffer::bufferedCount() const
+{
+    int n = 0;
+    const int depth = qMin(depthFrames(), int(kSlots));
+    for (int i = 0; i < depth; ++i) {
+        const quint32 seq = nextSeq_ + quint32(i);
+        const Slot& s = slots_[int(seq % kSlots)];
+        if (s.filled && s.seq == seq) ++n;
+    }
+    return n;
+}
+
+quint32 JitterBuffer::lowestBufferedSeq() const
+{
+    const int depth = qMin(depthFrames(), int(kSlots));
+    for (int i = 0; i < depth; ++i) {
+        const quint32 seq = nextSeq_ + quint32(i);
+        const Slot& s = slots_[int(seq % kSlots)];
+        if (s.filled && s.seq == seq) return seq;
+    }
+    return nextSeq_;
+}
+
+void JitterBuffer::goIdle()
+{
+    // 语音段结束：清空播放状态，但保留抖动估计与目标深度
+    for (Slot& s : slots_) s.filled = false;
+    playing_ = false;
+    haveAny_ = false;
+    started_ = false;
+    haveLast_ = false;
+    concealRun_ = 0;
+    sinceAdjust_ = 0;
+}
+
+void JitterBuffer::push(quint32 seq, qint64 ts, const qint16* pcm, int samples, qint64 arrivalMs,
+                        bool talkStart)
+{
+    if (!pcm || samples <= 0) return;
+
+    // 抖动估计：只看“到达时间 - 发送时间”的变化量，两端时钟偏移自然抵消
+    const qint64 transit = arrivalMs - ts;
+    if (haveTransit_) {
+        const double d = std::fabs(double(transit - lastTransit_));
+        jitter_ += (d - jitter_) / 16.0;
+        jitterPeak_ = qMax(jitterPeak_ * 0.995, d);
+    }
+    lastTransit_ = transit;
+    haveTransit_ = true;
+    updateTarget();
+
+    if (haveAny_) {
+        const qint32 ahead = qint32(seq - nextSeq_);
+        if (ahead >= kSlots || ahead <= -kSlots) {
+            // 序号跳变（对端重连/长时间中断）：整体重同步
+            reset();
+            haveTransit_ = true;
+            lastTransit_ = transit;
+        } else if (ahead < 0 && started_) {
+            return; // 播放点之后才到：迟到包直接丢弃
+        }
+    }
+
+    Slot& s = slotFor(seq);
+    if (s.filled && s.seq == seq) return; // 重复包
+
+    // 静音标记之后到达的新帧即新语音段（段首标记只是提示，不依赖它）：按常规预缓冲重新开播
+    if (talkStart || !haveAny_ || qint32(seq - maxSeq_) > 0) silence_ = false;
+    s.seq = seq;
+    s.filled = true;
+    const int n = qMin(samples, frameSamples_);
+    memcpy(s.pcm.data(), pcm, size_t(n) * sizeof(qint16));
+    if (n < frameSamples_) memset(s.pcm.data() + n, 0, size_t(frameSamples_ - n) * sizeof(qint16));
+
+    if (!haveAny_) {
+        haveAny_ = true;
+        nextSeq_ = maxSeq_ = seq;
+    } else {
+        if (qint32(seq - maxSeq_) > 0) maxSeq_ = seq;
+        if (!started_ && qint32(seq - nextSeq_) < 0) nextSeq_ = seq;
+    }
+}
+
+bool JitterBuffer::takeFrame(quint32 seq, qint16* out)
+{
+    Slot& s = slotFor(seq);
+    if (!s.filled || s.seq != seq) return false;
+    memcpy(out, s.pcm.constData(), size_t(frameSamples_) * sizeof(qint16));
+    s.filled = false;
+    return true;
+}
+
+void JitterBuffer::remember(const qint16* frame)
+{
+    memcpy(lastGood_.data(), frame, size_t(frameSamples_) * sizeof(qint16));
+    haveLast_ = true;
+    concealRun_ = 0;
+    if (++goodRun_ >= 500 && underrunBoost_ > 0) { // 连续 10s 正常播放后逐步回收欠载补偿
+        --underrunBoost_;
+        goodRun_ = 0;
+        updateTarget();
+    }
+}
+
+void JitterBuffer::conceal(qint16* out)
+{
+    // 重复上一帧并按连续丢失次数衰减，避免“咔哒”断音
+    ++concealRun_;
+    goodRun_ = 0;
+    if (!haveLast_) return; // out 已清零
+    const float att = std::pow(0.6f, float(concealRun_));
+    for (int i = 0; i < frameSamples_; ++i) out[i] = qint16(lastGood_[i] * att);
+}
+
+bool JitterBuffer::pop(qint16* out)
+{
+    memset(out, 0, size_t(frameSamples_) * sizeof(qint16));
+    if (!haveAny_) return false;
+
+    if (!playing_) {
+        // 预缓冲：攒够目标深度再开播
+        if (bufferedCount() < target_) return false;
+        nextSeq_ = lowestBufferedSeq();
+        playing_ = true;
+        started_ = true;
+        concealRun_ = 0;
+        sinceAdjust_ = 0;
+    }
+    ++sinceAdjust_;
+
+    // 严重积压（卡顿后突发到达）：直接丢到目标深度
+    while (depthFrames() > target_ + kMaxTarget) {
+        Slot& s = slotFor(nextSeq_);
+        if (s.seq == nextSeq_) s.filled = false;
+        ++nextSeq_;
+    }
+
+    const int depth = depthFrames();
+
+    // 加速：积压超过目标时，一次消耗两帧
+    if (depth > target_ + 2 && sinceAdjust_ >= kAdjustGap) {
+        Slot& a = slotFor(nextSeq_);
+        Slot& b = slotFor(nextSeq_ + 1);
+        if (a.filled && a.seq == nextSeq_ && b.filled && b.seq == nextSeq_ + 1) {
+            const qint16* pa = a.pcm.constData();
+            const qint16* pb = b.pcm.constData();
+            if (meanAbs(pa, frameSamples_) < kQuietAbsLevel) {
+                // 低能量帧直接丢弃，听感无损
+                memcpy(out, pb, size_t(frameSamples_) * sizeof(qint16));
+            } else {
+                // 两帧交叉淡化压成一帧
+                const float inv = 1.0f / frameSamples_;
+                for (int i = 0; i < frameSamples_; ++i) {
+                    const float w = i * inv;
+                    out[i] = qint16(pa[i] * (1.0f - w) + pb[i] * w);
+                }
+            }
+            a.filled = b.filled = false;
+            nextSeq_ += 2;
+            sinceAdjust_ = 0;
+            remember(out);
+            return true;
+        }
+    }
+
+    // 减速：缓冲快见底且上一帧是安静段时，重复一次安静帧拉长播放
+    if (depth > 0 && depth < target_ - 1 && sinceAdjust_ >= kAdjustGap
+        && haveLast_ && concealRun_ == 0
+        && meanAbs(lastGood_.constData(), frameSamples_) < kQuietAbsLevel) {
+        memcpy(out, lastGood_.constData(), size_t(frameSamples_) * sizeof(qint16));
+        sinceAdjust_ = 0;
+        return true;
+    }
+
+    if (takeFrame(nextSeq_, out)) {
+        ++nextSeq_;
+        remember(out);
+        return true;
+    }
+
+    // 当前帧缺失：后面已有更新的帧 -> 判定丢包；否则为欠载
+    const bool newerBuffered = qint32(maxSeq_ - nextSeq_) > 0;
+    if (silence_ && !newerBuffered) {
+        // 对端已进入静音段：缓冲放完是正常结束，不做隐藏也不加深目标
+        goIdle();
+        return false;
+    }
+    if (concealRun_ >= kMaxConceal) {
+        // 隐藏过久：静音并重新预缓冲，同时临时加深目标深度
+        playing_ = false;
+        haveLast_ = false;
+        concealRun_ = 0;
+        underrunBoost_ = qMin(underrunBoost_ + 1, 4);
+        updateTarget();
+        return false;
+    }
+    conceal(out);
+    if (newerBuffered) ++nextSeq_;
+    return true;
+}
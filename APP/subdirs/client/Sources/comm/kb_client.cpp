@@ -1,20 +1,18 @@
 #include "kb_client.h"
 
-QJsonObject KbClient::call(const QHostAddress& host, quint16 port, const QJsonObject& req, int msTimeout)
+quint64 KbClient::getRecordings(ApiClient* api, const QString& roomId,
+                                QObject* ctx, ApiClient::Callback cb)
 {
-    QTcpSocket s;
-    s.connectToHost(host, port);
-    if (!s.waitForConnected(msTimeout)) return QJsonObject{{"ok", false}, {"msg", "connect timeout"}};
-
-    QByteArray line = QJsonDocument(req).toJson(QJsonDocument::Compact) + '\n';
-    s.write(line);
-    s.flush();
+    QJsonObject req{{"action","get_recordings"}};
+    if (!roomId.isEmpty()) req["room_id"] = roomId;
+    return api->stream(req, ctx, std::move(cb));
+}
 
-    if (!s.waitForReadyRead(msTimeout)) return QJsonObject{{"ok", false}, {"msg", "no reply"}};
-    QByteArray reply = s.readLine().trimmed();
-    QJsonParseError pe{};
-    auto doc = QJsonDocument::fromJson(reply, &pe);
-    if (pe.error != QJsonParseError::NoError || !doc.isObject())
-        return QJsonObject{{"ok", false}, {"msg", "bad json"}};
-    return doc.object();
+quint64 KbClient::getRecordingFiles(ApiClient* api, int recordingId, const QString& roomId,
+                                    QObject* ctx, ApiClient::Callback cb)
+{
+    QJsonObject req{{"action","get_recording_files"}};
+    if (recordingId > 0) req["recording_id"] = recordingId;
+    if (!roomId.isEmpty()) req["room_id"] = roomId;
+    return api->stream(req, ctx, std::move(cb));
 }
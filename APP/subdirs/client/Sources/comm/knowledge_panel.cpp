@@ -1,5 +1,6 @@
 #include "knowledge_panel.h"
 #include "kb_client.h"
+#include "apiclient.h"
 
 #include <QHBoxLayout>
 #include <QVBoxLayout>
@@ -89,6 +90,8 @@ KnowledgePanel::KnowledgePanel(QWidget* parent)
     lay->addLayout(topBar);
     lay->addWidget(table_);
 
+    api_ = new ApiClient(this);
+
     connect(refreshBtn_, &QPushButton::clicked, this, &KnowledgePanel::refresh);
     connect(table_, &QTableWidget::cellDoubleClicked, this, &KnowledgePanel::onTableDoubleClicked);
 
@@ -114,6 +117,8 @@ QString KnowledgePanel::roomFilter() const { return roomEdit_->text().trimmed();
 
 void KnowledgePanel::setBusy(bool on)
 {
+    if (busy_ == on) return;
+    busy_ = on;
     refreshBtn_->setEnabled(!on);
     if (on) QApplication::setOverrideCursor(Qt::BusyCursor);
     else    QApplication::restoreOverrideCursor();
@@ -125,24 +130,46 @@ void KnowledgePanel::refresh()
     table_->setRowCount(0);
 
     const QString hostStr = hostEdit_->text().trimmed();
-    const QHostAddress host(hostStr);
     const quint16 port = quint16(portSpin_->value());
     const QString room = roomEdit_->text().trimmed();
 
     qInfo() << "[KB] refresh() host=" << hostStr << "port=" << port << "room=" << room;
+    api_->setServer(hostStr, port);
+
+    // 文件列表和录制列表都按块流式取回：同一连接上的请求按序应答，文件各块总是先于录制到达，
+    // 每到一块录制就按已归并的文件追加行，不必等全部取完才出表
+    const quint64 gen = ++refreshGen_;
+    filesByRec_.clear();
+
+    KbClient::getRecordingFiles(api_, 0, room, this, [this, gen](const QJsonObject& rep){
+        if (gen != refreshGen_) return;
+        if (!rep.value("ok").toBool()) {
+            qWarning() << "[KB] getRecordingFiles failed msg=" << rep.value("msg").toString();
+            return;
+        }
+        for (const auto& fv : rep.value("files").toArray()) {
+            const QJsonObject f = fv.toObject();
+            filesByRec_[f.value("recording_id").toInt()].append(f);
+        }
+    });
+    KbClient::getRecordings(api_, room, this, [this, gen](const QJsonObject& rep){
+        if (gen != refreshGen_) return;
+        if (!rep.value("ok").toBool()) {
+            setBusy(false);
+            QMessageBox::warning(this, QStringLiteral("查询失败"),
+                                 QStringLiteral("get_recordings 失败: %1").arg(rep.value("msg").toString()));
+            return;
+        }
+        appendRows(rep.value("items").toArray());
+        if (!rep.value("more").toBool()) {
+            filesByRec_.clear();
+            setBusy(false);
+        }
+    });
+}
 
-    const QJsonObject recResp = KbClient::getRecordings(host, port, room);
-    qInfo().noquote() << "[KB] recResp =" << QString::fromUtf8(QJsonDocument(recResp).toJson(QJsonDocument::Compact));
-
-    if (!recResp.value("ok").toBool()) {
-        QMessageBox::warning(this, QStringLiteral("查询失败"),
-                             QStringLiteral("get_recordings 失败: %1").arg(recResp.value("msg").toString()));
-        setBusy(false);
-        return;
-    }
-    const QJsonArray recItems = recResp.value("items").toArray();
-    qInfo() << "[KB] recordings count =" << recItems.size();
-
+void KnowledgePanel::appendRows(const QJsonArray& recItems)
+{
     int rowsAdded = 0;
 
     for (const auto& v : recItems) {
@@ -153,20 +180,7 @@ void KnowledgePanel::refresh()
         const QString started = rec.value("started_at").toVariant().toString();
         const QString ended   = rec.value("ended_at").toVariant().toString();
 
-        const QJsonObject filesResp = KbClient::getRecordingFiles(host, port, recId);
-        qInfo().noquote() << "[KB] filesResp(recId=" << recId << ") ="
-                          << QString::fromUtf8(QJsonDocument(filesResp).toJson(QJsonDocument::Compact));
-
-        if (!filesResp.value("ok").toBool()) {
-            qWarning() << "[KB] getRecordingFiles failed recId=" << recId
-                       << "msg=" << filesResp.value("msg").toString();
-            continue;
-        }
-        const QJsonArray files = filesResp.value("files").toArray();
-        qInfo() << "[KB] files count for recId=" << recId << ":" << files.size();
-
-        for (const auto& fv : files) {
-            const QJsonObject f = fv.toObject();
+        for (const QJsonObject& f : filesByRec_.value(recId)) {
             const QString user  = f.value("user").toString();
             const QString path  = f.value("file_path").toString();
             const QString kind  = f.value("kind").toString();
@@ -192,9 +206,8 @@ void KnowledgePanel::refresh()
         }
     }
 
-    qInfo() << "[KB] rows added to table =" << rowsAdded;
+    qInfo() << "[KB] recordings chunk =" << recItems.size() << "rows added =" << rowsAdded;
     table_->horizontalHeader()->setSectionResizeMode(3, QHeaderView::Stretch);
-    setBusy(false);
 }
 
 QString KnowledgePanel::findFfplay() const
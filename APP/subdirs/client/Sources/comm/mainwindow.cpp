@@ -15,6 +15,7 @@
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QGridLayout>
+#include <QGuiApplication>
 #include <QHBoxLayout>
 #include <QImageReader>
 #include <QImageWriter>
@@ -32,6 +33,7 @@
 #include <QPixmap>
 #include <QPushButton>
 #include <QRegExp>
+#include <QScreen>
 #include <QScrollArea>
 #include <QSet>
 #include <QStackedWidget>
@@ -39,6 +41,7 @@
 #include <QStyle>
 #include <QTextEdit>
 #include <QToolButton>
+#include <QToolTip>
 #include <QUrl>
 #include <QVBoxLayout>
 #include <QVideoFrame>
@@ -53,6 +56,7 @@
 #include "annotcanvas.h"
 #include "protocol.h"
 #include "udpmedia.h"
+#include "videodecodepool.h"
 #include "volume_popup.h"
 
 // ---------------------------- 小部件与帮助函数（聊天预览） ----------------------------
@@ -506,6 +510,10 @@ MainWindow::MainWindow(QWidget *parent)
     share_->setUdpClient(udp_);
     connect(share_, &ScreenShare::localFrameReady, this, &MainWindow::onLocalScreenFrame);
 
+    camPipe_ = new CameraPipeline(this);
+    connect(camPipe_, &CameraPipeline::previewReady, this, &MainWindow::updateLocalPreview);
+    connect(camPipe_, &CameraPipeline::layerEncoded, this, &MainWindow::onCameraLayer);
+
     // 绑定
 
     connect(btnConn,   &QPushButton::clicked, this, &MainWindow::onConnect);
@@ -535,72 +543,26 @@ MainWindow::MainWindow(QWidget *parent)
 
     bindVolumeButton(&localTile_, true);
 
+    // 远端视频统一交给解码池，GUI 线程只接成图
+    decodePool_ = new VideoDecodePool(this);
+    connect(decodePool_, &VideoDecodePool::frameDecoded, this, &MainWindow::onFrameDecoded);
+
     // UDP 收帧（整帧 JPEG 屏幕）
     connect(udp_, &UdpMediaClient::udpScreenFrame, this,
         [this](const QString& sender, const QByteArray& jpeg, int /*w*/, int /*h*/, qint64){
             if (sender.isEmpty() || sender == edUser->text()) return;
-            VideoTile* t = ensureRemoteTile(sender);
-            QBuffer buf(const_cast<QByteArray*>(&jpeg));
-            buf.open(QIODevice::ReadOnly);
-            QImageReader reader(&buf, "jpeg");
-            reader.setAutoTransform(true);
-            QImage img = reader.read().convertToFormat(QImage::Format_RGB32);
-            if (!img.isNull()) {
-                screenBack_[sender] = img; // 同步背板
-                t->lastScreen = img;
-                kickRemoteAlive(t);
-                refreshTilePixmap(t);
-                if (mainKey_ == sender) updateMainFromTile(t);
-            }
+            ensureRemoteTile(sender);
+            decodePool_->submitScreenJpeg(sender, jpeg);
         });
 
     // UDP 收帧（增量 DELTA 屏幕）
     connect(udp_, &UdpMediaClient::udpScreenDeltaFrame, this,
         [this](const QString& sender, const QByteArray& blob, int w, int h, qint64){
             if (sender.isEmpty() || sender == edUser->text()) return;
-            VideoTile* t = ensureRemoteTile(sender);
-
-            // 准备/校正背板尺寸
-            QImage& back = screenBack_[sender];
-            if (back.isNull() || back.size() != QSize(w, h)) {
-                back = QImage(w, h, QImage::Format_RGB32);
-                back.fill(Qt::black);
-            }
-
-            // 解析 DS01
-            QDataStream ds(blob);
-            ds.setByteOrder(QDataStream::BigEndian);
-            quint32 magic=0; quint16 rectCount=0;
-            ds >> magic >> rectCount;
-            if (magic != 0x44533031) return; // 'DS01'
-
-            for (int i = 0; i < rectCount; ++i) {
-                quint16 x=0,y=0,rw=0,rh=0; quint32 clen=0;
-                ds >> x >> y >> rw >> rh >> clen;
-                if (ds.status()!=QDataStream::Ok) return;
-                if (int(ds.device()->bytesAvailable()) < int(clen)) return;
-                QByteArray comp; comp.resize(int(clen));
-                ds.readRawData(comp.data(), clen);
-                QByteArray raw = qUncompress(comp);
-                if (raw.size() != int(rw) * int(rh) * 4) continue;
-
-                // 写回到背板
-                const char* src = raw.constData();
-                for (int row = 0; row < rh; ++row) {
-                    uchar* dst = back.scanLine(y + row) + x * 4;
-                    memcpy(dst, src + row * rw * 4, rw * 4);
-                }
-            }
-
-            // 显示更新
-            t->lastScreen = back;
-            kickRemoteAlive(t);
-            refreshTilePixmap(t);
-            if (mainKey_ == sender) updateMainFromTile(t);
+            ensureRemoteTile(sender);
+            decodePool_->submitScreenDelta(sender, blob, w, h);
         });
 
-    lastSend_.start();
-
     // 初始共享画质参数
     applyShareQualityPreset();
 
@@ -670,30 +632,24 @@ MainWindow::MainWindow(QWidget *parent)
     });
 
     // 画布事件 -> 本地应用 + 网络广播
-    connect(annotCanvas_, &AnnotCanvas::annotateEvent, this, [this](QJsonObject ev){
+    connect(annotCanvas_, &AnnotCanvas::annotateEvent, this, [this](QJsonObject ev, const QByteArray& pts){
         if (mainKey_.isEmpty()) return;
         ev["roomId"] = edRoom->text();
         ev["sender"] = edUser->text();
 
         if (auto* m = modelFor(ev.value("target").toString())) {
-            m->applyEvent(ev);
+            m->applyEvent(ev, pts);
         }
 
         QJsonObject evNet = ev;
         if (evNet.value("target").toString() == kLocalKey_) {
             evNet["target"] = edUser->text();
         }
-        conn_.send(MSG_ANNOT, evNet);
+        conn_.send(MSG_ANNOT, evNet, pts);
 
-        // 刷新
-        updateMainFitted();
+        // 刷新（与视频帧一起按显示刷新合并）
         const QString target = ev.value("target").toString();
-        if (target == kLocalKey_) {
-            refreshTilePixmap(&localTile_);
-        } else {
-            auto it = remoteTiles_.find(target);
-            if (it != remoteTiles_.end()) refreshTilePixmap(it.value());
-        }
+        scheduleTileRender(target == kLocalKey_ ? &localTile_ : remoteTiles_.value(target, nullptr));
     });
 
     setMainKey(QString());
@@ -751,6 +707,7 @@ void MainWindow::resizeEvent(QResizeEvent* ev)
     updateAllThumbFitted();
     updateMainFitted();
     if (annotCanvas_) annotCanvas_->setGeometry(mainVideo_->rect());
+    scheduleSubscription();
 }
 
 /* ---------- 网络 ---------- */
@@ -774,8 +731,13 @@ void MainWindow::onJoin()
     share_->setIdentity(edRoom->text(), edUser->text());
     udp_->setIdentity(edRoom->text(), edUser->text());
 
+    roster_.reset();   // 等新房间的成员快照
+    activeSpeaker_.clear();
     btnLeave_->setEnabled(true);
     applyShareQualityPreset();
+    lastSubscription_.clear();   // 服务端换房间会清掉旧订阅
+    camPipe_->setDemand(true, 0);   // 新房间的需求以服务端下发为准，在此之前照常发送
+    share_->setDemand(true);
 }
 
 void MainWindow::onLeave()
@@ -798,7 +760,10 @@ void MainWindow::onLeave()
         removeRemoteTile(key);
         it = remoteTiles_.begin();
     }
-    screenBack_.clear();
+    decodePool_->clear();
+    roster_.reset();
+    activeSpeaker_.clear();
+    if (audio_) audio_->dropPeer(AudioChat::kMixSender);
 
     // 清空标注
     for (auto* m : annotModels_) delete m;
@@ -930,10 +895,13 @@ void MainWindow::onSendFile()
 /* ---------- 自适应/协议处理 ---------- */
 void MainWindow::applyAdaptiveByMembers(int members)
 {
-    if (members <= 2) { sendSize_ = QSize(640,480); targetFps_ = 12; jpegQuality_ = 60; }
-    else if (members <= 4) { sendSize_ = QSize(480,360); targetFps_ = 10; jpegQuality_ = 55; }
-    else { sendSize_ = QSize(320,240); targetFps_ = 8;  jpegQuality_ = 50; }
+    // 多人房间改为联播：保留 640x480 顶层，由服务端按各接收端的窗口和带宽挑层，
+    // 不再把所有人一起降到小分辨率
+    if (members <= 2) { sendSize_ = QSize(640,480); targetFps_ = 12; jpegQuality_ = 60; simLayers_ = 1; }
+    else if (members <= 4) { sendSize_ = QSize(640,480); targetFps_ = 10; jpegQuality_ = 55; simLayers_ = 2; }
+    else { sendSize_ = QSize(640,480); targetFps_ = 8;  jpegQuality_ = 55; simLayers_ = 3; }
 
+    camPipe_->setParams(sendSize_, targetFps_, jpegQuality_, simLayers_);
     if (camera_) configureCamera(camera_);
     applyShareQualityPreset();
 }
@@ -973,21 +941,8 @@ void MainWindow::onPkt(Packet p)
         if (sender.isEmpty() || sender == edUser->text()) break;
 
         VideoTile* t = ensureRemoteTile(sender);
-
-        QBuffer buf(const_cast<QByteArray*>(&p.bin));
-        buf.open(QIODevice::ReadOnly);
-        QImageReader reader(&buf);
-        reader.setAutoTransform(true);
-        QImage img = reader.read();
-
         const QString media = p.json.value("media").toString("camera");
-        if (!img.isNull()) {
-            if (media == "screen") t->lastScreen = img;
-            else                    t->lastCam    = img;
-            kickRemoteAlive(t);
-            refreshTilePixmap(t);
-            if (mainKey_ == sender) updateMainFromTile(t);
-        }
+        decodePool_->submitPacket(sender, media, p.json, p.bin, decodeTargetFor(t));
         break;
     }
 
@@ -999,11 +954,11 @@ void MainWindow::onPkt(Packet p)
         if (!sender.isEmpty() && sender != edUser->text()) {
             VideoTile* t = ensureRemoteTile(sender);
             if (kind == "视频" || kind == "video") {
-                if (state == "off") t->lastCam = QImage();
+                if (state == "off") { decodePool_->removeSender(sender, "camera"); t->lastCam = QImage(); }
                 refreshTilePixmap(t);
                 if (mainKey_ == sender) updateMainFromTile(t);
             } else if (kind == "screen") {
-                if (state == "off") t->lastScreen = QImage();
+                if (state == "off") { decodePool_->removeSender(sender, "screen"); t->lastScreen = QImage(); }
                 refreshTilePixmap(t);
                 if (mainKey_ == sender) updateMainFromTile(t);
             }
@@ -1015,9 +970,17 @@ void MainWindow::onPkt(Packet p)
     {
         const QString kind = p.json.value("kind").toString();
         if (kind == "room") {
-            QStringList members;
-            for (auto v : p.json.value("members").toArray())
-                members << v.toString();
+            if (p.json.value("roomId").toString() != edRoom->text()) break;
+            const RoomRoster::Result r = roster_.apply(p.json);
+            if (r == RoomRoster::Gap) {
+                // 增量断档：要一次全量，补发到之前保持现状
+                QJsonObject req{{"roomId", edRoom->text()}, {"sender", edUser->text()}, {"kind", "members"}};
+                conn_.send(MSG_CONTROL, req);
+                break;
+            }
+            if (r == RoomRoster::Ignored) break;
+            const QStringList members = roster_.members();
+            if (audio_) audio_->setMembers(members);
 
             QSet<QString> shouldHave = QSet<QString>::fromList(members);
             shouldHave.remove(edUser->text());
@@ -1043,6 +1006,30 @@ void MainWindow::onPkt(Packet p)
 
             if (currentMode() == ViewMode::Grid) refreshGridOnly();
             else refreshFocusThumbs();
+        } else if (kind == "demand") {
+            // 服务端汇总的观看需求：决定是否编码摄像头/屏幕以及摄像头从哪一层编起
+            if (p.json.value("roomId").toString() != edRoom->text()) break;
+            camPipe_->setDemand(p.json.value("camera").toBool(true), p.json.value("topLayer").toInt(0));
+            if (share_) share_->setDemand(p.json.value("screen").toBool(true));
+        } else if (kind == "keyframe") {
+            // 有接收端在等某个联播层的关键帧（刚换层或该层刚恢复编码）
+            if (p.json.value("roomId").toString() != edRoom->text()) break;
+            if (p.json.value("media").toString("camera") == "camera")
+                camPipe_->requestKeyframe(p.json.value("layer").toInt(0));
+        } else if (kind == "audio_mode") {
+            // 服务端退出混音、改回逐路转发：混音流不会再来，释放它的槽位
+            if (p.json.value("roomId").toString() != edRoom->text()) break;
+            if (p.json.value("mode").toString() != "mix" && audio_) audio_->dropPeer(AudioChat::kMixSender);
+        } else if (kind == "speaker") {
+            // 服务端判定的主讲人：给对应小窗加高亮边框
+            const QString who = p.json.value("who").toString();
+            if (activeSpeaker_ != who) {
+                if (VideoTile* old = remoteTiles_.value(activeSpeaker_, nullptr))
+                    old->video->setStyleSheet("border:1px solid #888;");
+                activeSpeaker_ = who;
+                if (VideoTile* t = remoteTiles_.value(who, nullptr))
+                    t->video->setStyleSheet("border:2px solid #3c3;");
+            }
         }
         break;
     }
@@ -1057,17 +1044,11 @@ void MainWindow::onPkt(Packet p)
         if (target.isEmpty()) break;
 
         if (auto* m = modelFor(target)) {
-            if (m->applyEvent(p.json)) {
-                if (mainKey_ == target) {
-                    updateMainFitted();
-                }
-                if (target == kLocalKey_) {
-                    refreshTilePixmap(&localTile_);
-                } else {
-                    auto it = remoteTiles_.find(target);
-                    if (it != remoteTiles_.end()) refreshTilePixmap(it.value());
-                }
-            }
+            bool changed = m->applyEvent(p.json, p.bin);
+            // 顺带结束超时未收到 end 的笔画（发送端崩溃/断线），免得挡住后续笔画进缓存层
+            if (m->finishIdle() > 0) changed = true;
+            if (changed)
+                scheduleTileRender(target == kLocalKey_ ? &localTile_ : remoteTiles_.value(target, nullptr));
         }
         break;
     }
@@ -1232,120 +1213,44 @@ void MainWindow::configureCamera(QCamera* cam)
 }
 
 /* ---------- 帧处理 ---------- */
-QImage MainWindow::makeImageFromFrame(const QVideoFrame &frame)
-{
-    if (!frame.isValid()) return QImage();
-
-    QVideoFrame clone(frame);
-    if (!clone.map(QAbstractVideoBuffer::ReadOnly)) {
-        return QImage();
-    }
-
-    const auto fmt = clone.pixelFormat();
-    const QImage::Format imf = QVideoFrame::imageFormatFromPixelFormat(fmt);
-    if (imf != QImage::Format_Invalid) {
-        QImage img(clone.bits(), clone.width(), clone.height(), clone.bytesPerLine(), imf);
-        QImage copy = img.copy();
-        clone.unmap();
-        return copy;
-    }
-
-    if (fmt == QVideoFrame::Format_YUYV) {
-        const uchar *base = clone.bits();
-        const int width = clone.width();
-        const int height = clone.height();
-        const int stride = clone.bytesPerLine();
-
-        QImage out(width, height, QImage::Format_RGB32);
-        auto clip = [](int v){ return v < 0 ? 0 : (v > 255 ? 255 : v); };
-
-        for (int y = 0; y < height; ++y) {
-            const uchar* line = base + y * stride;
-            QRgb* dst = reinterpret_cast<QRgb*>(out.scanLine(y));
-            for (int x = 0; x < width; x += 2) {
-                const int i = x << 1;
-                int y0 = line[i + 0] - 16;
-                int u  = line[i + 1] - 128;
-                int y1 = line[i + 2] - 16;
-                int v  = line[i + 3] - 128;
-
-                int r0 = clip((298 * y0 + 409 * v + 128) >> 8);
-                int g0 = clip((298 * y0 - 100 * u - 208 * v + 128) >> 8);
-                int b0 = clip((298 * y0 + 516 * u + 128) >> 8);
-
-                int r1 = clip((298 * y1 + 409 * v + 128) >> 8);
-                int g1 = clip((298 * y1 - 100 * u - 208 * v + 128) >> 8);
-                int b1 = clip((298 * y1 + 516 * u + 128) >> 8);
-
-                dst[x]     = qRgb(r0, g0, b0);
-                if (x + 1 < width)
-                    dst[x + 1] = qRgb(r1, g1, b1);
-            }
-        }
-        clone.unmap();
-        return out;
-    }
-
-    clone.unmap();
-    return QImage();
-}
-
 void MainWindow::updateLocalPreview(const QImage& img)
 {
-    if (img.isNull()) return;
+    if (img.isNull() || !camera_) return;   // 关摄像头后工作线程可能还有一帧在路上
     localTile_.lastCam = img;
-    refreshTilePixmap(&localTile_);
-    if (mainKey_ == kLocalKey_) updateMainFromTile(&localTile_);
+    scheduleTileRender(&localTile_);
 }
 
 void MainWindow::onLocalScreenFrame(QImage img)
 {
     if (img.isNull()) return;
     localTile_.lastScreen = img;
-    refreshTilePixmap(&localTile_);
-    if (mainKey_ == kLocalKey_) updateMainFromTile(&localTile_);
+    scheduleTileRender(&localTile_);
 }
 
-void MainWindow::sendImage(const QImage& img)
+void MainWindow::onCameraLayer(QByteArray data, QSize size, int layer, int layers, int top, qint64 ts, QJsonObject codec)
 {
-    if (img.isNull()) return;
-
-    const qint64 intervalMs = 1000 / qMax(1, targetFps_);
-    if (lastSend_.isValid() && lastSend_.elapsed() < intervalMs)
-        return;
-    lastSend_.restart();
-
-    const QImage scaled = img.scaled(sendSize_, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-    QByteArray jpeg;
-    QBuffer buffer(&jpeg);
-    buffer.open(QIODevice::WriteOnly);
-    QImageWriter writer(&buffer, "jpeg");
-    writer.setQuality(jpegQuality_);
-    writer.setOptimizedWrite(true);
-    if (!writer.write(scaled)) {
-        return;
-    }
-    buffer.close();
-
+    if (!camera_) return;
     QJsonObject j{{"roomId", edRoom->text()},
                   {"sender", edUser->text()},
                   {"media",  "camera"},
-                  {"w", scaled.width()},
-                  {"h", scaled.height()},
-                  {"ts", QDateTime::currentMSecsSinceEpoch()}};
-    conn_.send(MSG_VIDEO_FRAME, j, jpeg);
+                  {"w", size.width()},
+                  {"h", size.height()},
+                  {"ts", ts}};
+    for (auto it = codec.constBegin(); it != codec.constEnd(); ++it) j.insert(it.key(), it.value());
+    // 联播：layer/layers 告诉服务端这是第几层，top 为本帧编码的第一层
+    if (layers > 1) {
+        j["layer"]  = layer;
+        j["layers"] = layers;
+        j["top"]    = top;
+    }
+    conn_.send(MSG_VIDEO_FRAME, j, data);
 }
 
 void MainWindow::onVideoFrame(const QVideoFrame &frame)
 {
     if (!camera_ || !frame.isValid()) return;
-
-    QImage img = makeImageFromFrame(frame);
-    if (img.isNull()) return;
-
-    updateLocalPreview(img);
-    sendImage(img);
+    // 转换、缩放、编码都在工作线程；忙时丢帧，预览按显示帧率回送
+    camPipe_->submit(frame);
 }
 
 /* ---------- 视图/缩略图 ---------- */
@@ -1374,6 +1279,8 @@ VideoTile* MainWindow::ensureRemoteTile(const QString& sender)
 
     remoteTiles_.insert(sender, t);
     bindVolumeButton(t, false);
+    // 主讲人事件可能先于该小窗到达（中途入会、之后才开摄像头），建窗时补上高亮
+    if (sender == activeSpeaker_) t->video->setStyleSheet("border:2px solid #3c3;");
 
     if (currentMode() == ViewMode::Grid) refreshGridOnly();
     else refreshFocusThumbs();
@@ -1392,9 +1299,16 @@ void MainWindow::removeRemoteTile(const QString& sender)
     }
     t->box->deleteLater();
     remoteTiles_.erase(it);
+    decodePool_->removeSender(sender);
 
     if (audio_) audio_->dropPeer(sender);
 
+    // 离开者在别人画面上画到一半的笔画按已结束处理，其余笔画才能继续进缓存层
+    for (auto mi = annotModels_.constBegin(); mi != annotModels_.constEnd(); ++mi) {
+        if (mi.value()->finishOwner(sender) > 0)
+            scheduleTileRender(mi.key() == kLocalKey_ ? &localTile_ : remoteTiles_.value(mi.key(), nullptr));
+    }
+
     if (currentMode() == ViewMode::Grid) refreshGridOnly();
     else refreshFocusThumbs();
 }
@@ -1432,6 +1346,7 @@ void MainWindow::refreshGridOnly()
 
     centerStack_->setCurrentWidget(gridPage_);
     updateAllThumbFitted();
+    scheduleSubscription();
 }
 
 void MainWindow::refreshFocusThumbs()
@@ -1470,6 +1385,85 @@ void MainWindow::refreshFocusThumbs()
     centerStack_->setCurrentWidget(focusPage_);
     updateAllThumbFitted();
     updateMainFitted();
+    scheduleSubscription();
+}
+
+void MainWindow::scheduleTileRender(VideoTile* t)
+{
+    if (!t) return;
+    dirtyTiles_.insert(t->key);
+    if (t->key == mainKey_) mainDirty_ = true;
+    if (!renderTimer_) {
+        renderTimer_ = new QTimer(this);
+        renderTimer_->setSingleShot(true);
+        renderTimer_->setTimerType(Qt::PreciseTimer);
+        connect(renderTimer_, &QTimer::timeout, this, &MainWindow::renderDirtyTiles);
+    }
+    if (renderTimer_->isActive()) return;
+    const QScreen* scr = QGuiApplication::primaryScreen();
+    const qreal hz = scr ? scr->refreshRate() : 60.0;
+    renderTimer_->start(qBound(4, int(1000.0 / qMax<qreal>(1.0, hz)), 50));
+}
+
+// 一个刷新周期内同一格子不论来了几帧只合成一次；隐藏的格子不合成（重新显示时布局刷新会重绘），
+// 被滚出可视区的留在脏集合里，等下一轮有新帧时再检查
+void MainWindow::renderDirtyTiles()
+{
+    const QSet<QString> keys = dirtyTiles_;
+    dirtyTiles_.clear();
+    for (const QString& key : keys) {
+        VideoTile* t = (key == kLocalKey_) ? &localTile_ : remoteTiles_.value(key, nullptr);
+        if (!t || !t->video || !t->video->isVisible()) continue;
+        if (t->video->visibleRegion().isEmpty()) { dirtyTiles_.insert(key); continue; }
+        refreshTilePixmap(t);
+    }
+
+    if (mainDirty_) {
+        mainDirty_ = false;
+        if (mainVideo_->isVisible()) updateMainFitted();
+    }
+}
+
+void MainWindow::scheduleSubscription()
+{
+    if (!subTimer_) {
+        subTimer_ = new QTimer(this);
+        subTimer_->setSingleShot(true);
+        subTimer_->setInterval(200);
+        connect(subTimer_, &QTimer::timeout, this, &MainWindow::sendSubscription);
+    }
+    subTimer_->start();
+}
+
+void MainWindow::sendSubscription()
+{
+    if (edRoom->text().isEmpty() || !btnLeave_->isEnabled()) return;
+
+    // 网格：每个格子按自身尺寸；焦点：主画面全帧率，右侧缩略图降帧
+    const bool grid = (currentMode() == ViewMode::Grid);
+    const int camFps = remoteTiles_.size() > 4 ? 10 : 15;
+    QJsonArray streams;
+    for (auto* t : remoteTiles_) {
+        const bool isMain = !grid && t->key == mainKey_;
+        const QSize sz = isMain ? mainVideo_->size() : t->video->size();
+        int cam = camFps, scr = 0;
+        if (isMain)     cam = 0;
+        else if (!grid) { cam = 5; scr = 2; }
+        streams.append(QJsonObject{{"sender", t->key}, {"media", "camera"},
+                                   {"maxW", sz.width()}, {"maxH", sz.height()}, {"fps", cam}});
+        streams.append(QJsonObject{{"sender", t->key}, {"media", "screen"},
+                                   {"maxW", sz.width()}, {"maxH", sz.height()}, {"fps", scr}});
+    }
+
+    QJsonObject j{{"kind", "subscribe"},
+                  {"roomId", edRoom->text()},
+                  {"sender", edUser->text()},
+                  {"lastN", kSubscribeLastN},
+                  {"streams", streams}};
+    const QByteArray sig = QJsonDocument(j).toJson(QJsonDocument::Compact);
+    if (sig == lastSubscription_) return;
+    lastSubscription_ = sig;
+    conn_.send(MSG_CONTROL, j);
 }
 
 void MainWindow::setTileWaiting(VideoTile* t, const QString& text)
@@ -1560,7 +1554,7 @@ void MainWindow::updateMainFitted()
         if (it != remoteTiles_.end()) t = it.value();
     }
     if (t) updateMainFromTile(t);
-    if (annotCanvas_) annotCanvas_->update(); // 确保标注在主画面重绘
+    if (annotCanvas_) annotCanvas_->refreshDirty(); // 标注有变化的区域在主画面重绘
 }
 
 void MainWindow::refreshTilePixmap(VideoTile* t)
@@ -1586,6 +1580,25 @@ void MainWindow::refreshTilePixmap(VideoTile* t)
     fitLabelImage(t->video, composed);
 }
 
+void MainWindow::onFrameDecoded(QString sender, QString media, QImage img, quint64 gen)
+{
+    // 该路已关闭/成员已离开（或之后重建了同名通道）：排队中的旧结果直接丢弃，不能让瓦片“复活”
+    if (!decodePool_->isCurrent(sender, media, gen)) return;
+    VideoTile* t = remoteTiles_.value(sender, nullptr);
+    if (!t || img.isNull()) return;
+    if (media == "screen") t->lastScreen = img;
+    else                    t->lastCam    = img;
+    kickRemoteAlive(t);
+    scheduleTileRender(t);
+}
+
+QSize MainWindow::decodeTargetFor(const VideoTile* t) const
+{
+    if (!t || !t->video) return QSize();
+    if (centerStack_->currentWidget() == focusPage_ && mainKey_ == t->key) return QSize();
+    return t->video->size();
+}
+
 void MainWindow::togglePiP(VideoTile* t)
 {
     if (!t) return;
@@ -1619,6 +1632,11 @@ void MainWindow::bindVolumeButton(VideoTile* t, bool isLocal)
 {
     if (!t || !t->volBtn) return;
     connect(t->volBtn, &QToolButton::clicked, this, [this, t, isLocal](){
+        if (!isLocal && audio_ && audio_->mixMode()) {   // 服务端混音时远端已合成一路，无法单独调节
+            QToolTip::showText(t->volBtn->mapToGlobal(QPoint(0, t->volBtn->height())),
+                               QStringLiteral("服务端混音中，单路音量不可用，请调节总音量"), t->volBtn);
+            return;
+        }
         auto* popup = new VolumePopup(this);
         popup->setAttribute(Qt::WA_DeleteOnClose, true);
 
@@ -0,0 +1,37 @@
+#include "roomroster.h"
+
+RoomRoster::Result RoomRoster::apply(const QJsonObject& j)
+{
+    const bool hasVersion = j.contains("version");
+    const quint64 v = quint64(j.value("version").toDouble());
+
+    // 全量：入会快照、补发的快照、旧服务端的每条事件
+    if (j.contains("members")) {
+        if (hasVersion && synced_ && v < version_) return Ignored;
+        users_.clear();
+        for (auto m : j.value("members").toArray()) users_.insert(m.toString());
+        version_ = v;
+        synced_ = true;
+        return Applied;
+    }
+
+    if (!hasVersion) return Ignored;
+    if (!synced_) return Gap;
+    if (v <= version_) return Ignored;
+    if (v != version_ + 1) return Gap;
+
+    const QString who = j.value("who").toString();
+    const QString ev  = j.value("event").toString();
+    if (ev == "join")       users_.insert(who);
+    else if (ev == "leave") users_.remove(who);
+    else return Gap;   // 不认识的增量，按断档处理
+    version_ = v;
+    return Applied;
+}
+
+QStringList RoomRoster::members() const
+{
+    QStringList out = users_.values();
+    out.sort();
+    return out;
+}
@@ -34,7 +34,7 @@ void ScreenShare::setEnabled(bool on) {
         sendControl("on");
         lastKeyMs_ = 0;
         prevFrame_ = QImage();
-        scheduleNext();
+        if (demand_) scheduleNext();
     } else {
         timer_.stop();
         prevFrame_ = QImage();
@@ -42,6 +42,20 @@ void ScreenShare::setEnabled(bool on) {
     }
 }
 
+void ScreenShare::setDemand(bool wanted) {
+    if (demand_ == wanted) return;
+    demand_ = wanted;
+    qInfo() << "[share] demand" << (wanted ? "resume" : "pause");
+    if (!enabled_) return;
+    prevFrame_ = QImage();
+    if (demand_) {
+        lastKeyMs_ = 0;   // 暂停期间的增量都没发，恢复后必须从关键帧开始
+        scheduleNext();
+    } else {
+        timer_.stop();
+    }
+}
+
 void ScreenShare::sendControl(const char* state) {
     if (!conn_) return;
     QJsonObject j{
@@ -71,7 +85,7 @@ void ScreenShare::scheduleNext() {
 }
 
 void ScreenShare::onTick() {
-    if (!enabled_) return;
+    if (!enabled_ || !demand_) return;
 
     // 抓取主屏并缩放到不低于 720p 的目标
     QScreen* scr = QGuiApplication::primaryScreen();
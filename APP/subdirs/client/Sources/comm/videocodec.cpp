@@ -0,0 +1,241 @@
+#include "videocodec.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define VIDEOCODEC_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define VIDEOCODEC_NEON 1
+#endif
+
+namespace VideoCodec {
+
+static constexpr quint32 kMagic = 0x43523031;   // 'CR01'
+
+QByteArray encodeJpeg(const QImage& img, int quality)
+{
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, "jpeg");
+    writer.setQuality(quality);
+    writer.setOptimizedWrite(true);
+    if (!writer.write(img)) return QByteArray();
+    return jpeg;
+}
+
+int fitShift(const QSize& full, const QSize& target)
+{
+    if (!target.isValid() || target.isEmpty() || full.isEmpty()) return 0;
+    const QSize fit = full.scaled(target, Qt::KeepAspectRatio);
+    int shift = 0;
+    while (shift < kMaxDecodeShift
+           && (full.width() >> (shift + 1)) >= fit.width() && (full.height() >> (shift + 1)) >= fit.height()) ++shift;
+    return shift;
+}
+
+// shift < 0 时按 target 现算；full/used 回填原始尺寸与实际缩小级数
+// 请求尺寸取向下取整，Qt 的 jpeg 插件据此选中 1/2^shift 的 DCT 缩放
+static QImage readJpeg(const QByteArray& data, int shift, const QSize& target, QSize* full = nullptr, int* used = nullptr)
+{
+    QBuffer buf(const_cast<QByteArray*>(&data));
+    buf.open(QIODevice::ReadOnly);
+    QImageReader reader(&buf, "jpeg");
+    reader.setAutoTransform(true);
+    const QSize size = reader.size();
+    if (shift < 0) shift = fitShift(size, target);
+    if (shift > 0 && size.isValid())
+        reader.setScaledSize(QSize(qMax(1, size.width() >> shift), qMax(1, size.height() >> shift)));
+    else shift = 0;
+    if (full) *full = size;
+    if (used) *used = shift;
+    return reader.read().convertToFormat(QImage::Format_RGB32);
+}
+
+QImage decodeJpeg(const QByteArray& data, const QSize& target)
+{
+    return readJpeg(data, -1, target);
+}
+
+// 一行 RGB32 像素的绝对差之和（alpha 恒为 0xff，不影响结果）
+static quint32 rowSad(const uchar* a, const uchar* b, int pixels)
+{
+    int i = 0;
+    quint32 sum = 0;
+#if defined(VIDEOCODEC_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 4 <= pixels; i += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 4 * i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 4 * i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(x, y));
+    }
+    sum = quint32(_mm_cvtsi128_si32(acc)) + quint32(_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#elif defined(VIDEOCODEC_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 4 <= pixels; i += 4) {
+        const uint8x16_t d = vabdq_u8(vld1q_u8(a + 4 * i), vld1q_u8(b + 4 * i));
+        acc = vpadalq_u16(acc, vpaddlq_u8(d));
+    }
+    sum = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+    for (int k = 4 * i; k < 4 * pixels; ++k) sum += quint32(qAbs(int(a[k]) - int(b[k])));
+    return sum;
+}
+
+void CrEncoder::reset()
+{
+    key_ = QImage();
+    keyMs_ = 0;
+    lastSentMs_ = 0;
+    lastEmpty_ = false;
+}
+
+bool CrEncoder::encode(const QImage& src, int quality, qint64 nowMs, QByteArray* out, QJsonObject* info)
+{
+    const QImage img = (src.format() == QImage::Format_RGB32) ? src : src.convertToFormat(QImage::Format_RGB32);
+    const int W = img.width(), H = img.height();
+    if (W <= 0 || H <= 0 || W > 0xffff || H > 0xffff) return false;
+
+    bool needKey = key_.isNull() || key_.size() != img.size() || nowMs - keyMs_ >= kKeyIntervalMs;
+    QVector<QPoint> changed;
+    if (!needKey) {
+        const int bx = (W + kBlock - 1) / kBlock;
+        const int by = (H + kBlock - 1) / kBlock;
+        for (int gy = 0; gy < by; ++gy) {
+            const int y0 = gy * kBlock, h = qMin(int(kBlock), H - y0);
+            for (int gx = 0; gx < bx; ++gx) {
+                const int x0 = gx * kBlock, w = qMin(int(kBlock), W - x0);
+                quint32 sad = 0;
+                for (int r = 0; r < h; ++r)
+                    sad += rowSad(img.constScanLine(y0 + r) + x0 * 4, key_.constScanLine(y0 + r) + x0 * 4, w);
+                if (sad > quint32(kNoiseMean * w * h * 3)) changed.append(QPoint(gx, gy));
+            }
+        }
+        if (changed.size() * 100 > bx * by * kMaxDeltaPercent) needKey = true;
+    }
+
+    if (needKey) {
+        *out = encodeJpeg(img, quality);
+        if (out->isEmpty()) return false;
+        key_ = img;
+        ++keyId_;
+        keyMs_ = lastSentMs_ = nowMs;
+        lastEmpty_ = false;
+        *info = QJsonObject{{"codec", "cr"}, {"frame", "key"}, {"key", double(keyId_)}};
+        return true;
+    }
+
+    // 连续静止：空增量只按刷新间隔发
+    if (changed.isEmpty() && lastEmpty_ && nowMs - lastSentMs_ < kIdleRefreshMs) return false;
+
+    QByteArray atlasJpeg;
+    if (!changed.isEmpty()) {
+        const int cols = qMin(changed.size(), int(kAtlasCols));
+        const int rows = (changed.size() + cols - 1) / cols;
+        QImage atlas(cols * kBlock, rows * kBlock, QImage::Format_RGB32);
+        atlas.fill(Qt::black);
+        for (int i = 0; i < changed.size(); ++i) {
+            const int x0 = changed[i].x() * kBlock, y0 = changed[i].y() * kBlock;
+            const int w = qMin(int(kBlock), W - x0), h = qMin(int(kBlock), H - y0);
+            const int ax = (i % cols) * kBlock, ay = (i / cols) * kBlock;
+            for (int r = 0; r < h; ++r)
+                std::memcpy(atlas.scanLine(ay + r) + ax * 4, img.constScanLine(y0 + r) + x0 * 4, size_t(w) * 4);
+        }
+        atlasJpeg = encodeJpeg(atlas, quality);
+        if (atlasJpeg.isEmpty()) return false;
+    }
+
+    QByteArray blob;
+    blob.reserve(16 + changed.size() * 4 + atlasJpeg.size());
+    QDataStream ds(&blob, QIODevice::WriteOnly);
+    ds.setByteOrder(QDataStream::BigEndian);
+    ds << kMagic << keyId_ << quint16(W) << quint16(H) << quint16(changed.size());
+    for (const QPoint& b : changed) ds << quint16(b.x()) << quint16(b.y());
+    ds << quint32(atlasJpeg.size());
+    ds.writeRawData(atlasJpeg.constData(), atlasJpeg.size());
+
+    *out = blob;
+    *info = QJsonObject{{"codec", "cr"}, {"frame", "delta"}, {"key", double(keyId_)}};
+    lastSentMs_ = nowMs;
+    lastEmpty_ = changed.isEmpty();
+    return true;
+}
+
+void CrDecoder::reset()
+{
+    key_ = QImage();
+    keyJpeg_.clear();
+    keySize_ = QSize();
+    shift_ = 0;
+    haveKey_ = false;
+}
+
+bool CrDecoder::decode(const QJsonObject& j, const QByteArray& bin, QImage* out, const QSize& target)
+{
+    if (j.value("codec").toString() != "cr" || j.value("frame").toString() != "delta") {
+        QSize full;
+        int shift = 0;
+        QImage img = readJpeg(bin, -1, target, &full, &shift);
+        if (img.isNull()) return false;
+        if (j.value("codec").toString() == "cr") {
+            key_ = img;
+            keyJpeg_ = bin;
+            keySize_ = full;
+            shift_ = shift;
+            keyId_ = quint32(j.value("key").toDouble());
+            haveKey_ = true;
+        }
+        *out = img;
+        return true;
+    }
+
+    QDataStream ds(bin);
+    ds.setByteOrder(QDataStream::BigEndian);
+    quint32 magic = 0, keyId = 0;
+    quint16 W = 0, H = 0, count = 0;
+    ds >> magic >> keyId >> W >> H >> count;
+    if (ds.status() != QDataStream::Ok || magic != kMagic) return false;
+    // 关键帧没收到（刚入会、刚切层）：等下一个关键帧
+    if (!haveKey_ || keyId != keyId_ || keySize_ != QSize(W, H)) return false;
+
+    // 显示尺寸跨过了缩放级：关键帧按新比例重解一次，之后的增量都贴在它上面
+    const int shift = fitShift(keySize_, target);
+    if (shift != shift_) {
+        const QImage k = readJpeg(keyJpeg_, shift, QSize());
+        if (k.isNull()) return false;
+        key_ = k;
+        shift_ = shift;
+    }
+
+    QVector<QPoint> blocks(count);
+    for (int i = 0; i < count; ++i) {
+        quint16 bx = 0, by = 0;
+        ds >> bx >> by;
+        blocks[i] = QPoint(bx, by);
+    }
+    quint32 len = 0;
+    ds >> len;
+    if (ds.status() != QDataStream::Ok || len > quint32(ds.device()->bytesAvailable())) return false;
+
+    QImage img = key_.copy();
+    if (count > 0) {
+        // 宏块边长是 JPEG 块的整数倍，图集按同一比例缩小后每块正好 kBlock >> shift 像素
+        const QImage atlas = readJpeg(bin.mid(int(ds.device()->pos()), int(len)), shift_, QSize());
+        const int cols = qMin(int(count), int(kAtlasCols));
+        const int b = kBlock >> shift_;
+        if (atlas.isNull() || atlas.width() < cols * b) return false;
+        for (int i = 0; i < count; ++i) {
+            const int x0 = (blocks[i].x() * kBlock) >> shift_, y0 = (blocks[i].y() * kBlock) >> shift_;
+            const int ax = (i % cols) * b, ay = (i / cols) * b;
+            if (x0 >= img.width() || y0 >= img.height() || ay + b > atlas.height()) continue;
+            const int w = qMin(b, img.width() - x0), h = qMin(b, img.height() - y0);
+            for (int r = 0; r < h; ++r)
+                std::memcpy(img.scanLine(y0 + r) + x0 * 4, atlas.constScanLine(ay + r) + ax * 4, size_t(w) * 4);
+        }
+    }
+    *out = img;
+    return true;
+}
+
+} // namespace VideoCodec
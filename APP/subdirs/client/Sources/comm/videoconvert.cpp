@@ -0,0 +1,252 @@
+#include "videoconvert.h"
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define VIDEOCONV_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define VIDEOCONV_NEON 1
+#endif
+
+namespace VideoConvert {
+
+// 6bit 定点 BT.601：298/409/100/208/516 各除以 4
+enum { kCy = 74, kCrv = 102, kCgu = 25, kCgv = 52, kCbu = 129 };
+
+static inline quint8 clip8(int v) { return quint8(v < 0 ? 0 : (v > 255 ? 255 : v)); }
+
+static inline quint32 pixel(int y, int u, int v)
+{
+    const int yy = (y - 16) * kCy;
+    const int uu = u - 128, vv = v - 128;
+    const quint8 r = clip8((yy + kCrv * vv + 32) >> 6);
+    const quint8 g = clip8((yy - kCgu * uu - kCgv * vv + 32) >> 6);
+    const quint8 b = clip8((yy + kCbu * uu + 32) >> 6);
+    return 0xff000000u | (quint32(r) << 16) | (quint32(g) << 8) | b;
+}
+
+void yuvRowToRgb32(const quint8* y, const quint8* u, const quint8* v, quint32* dst, int width)
+{
+    int x = 0;
+#if defined(VIDEOCONV_SSE2)
+    // 每次 8 个像素：16bit 饱和运算，超出范围的中间值最终都会被 packus 截到 0/255，与标量一致
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c16  = _mm_set1_epi16(16);
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i rnd  = _mm_set1_epi16(32);
+    const __m128i alpha = _mm_set1_epi8(char(0xff));
+    for (; x + 8 <= width; x += 8) {
+        qint32 u4, v4;
+        std::memcpy(&u4, u + x / 2, 4);
+        std::memcpy(&v4, v + x / 2, 4);
+        __m128i uu = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(u4), zero), c128);
+        __m128i vv = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v4), zero), c128);
+        uu = _mm_unpacklo_epi16(uu, uu);
+        vv = _mm_unpacklo_epi16(vv, vv);
+        const __m128i yy = _mm_mullo_epi16(
+            _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + x)), zero), c16),
+            _mm_set1_epi16(kCy));
+
+        __m128i r = _mm_adds_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(vv, _mm_set1_epi16(kCrv))), rnd);
+        __m128i g = _mm_subs_epi16(yy, _mm_mullo_epi16(uu, _mm_set1_epi16(kCgu)));
+        g = _mm_adds_epi16(_mm_subs_epi16(g, _mm_mullo_epi16(vv, _mm_set1_epi16(kCgv))), rnd);
+        __m128i b = _mm_adds_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(uu, _mm_set1_epi16(kCbu))), rnd);
+        r = _mm_packus_epi16(_mm_srai_epi16(r, 6), zero);
+        g = _mm_packus_epi16(_mm_srai_epi16(g, 6), zero);
+        b = _mm_packus_epi16(_mm_srai_epi16(b, 6), zero);
+
+        // 内存顺序 B G R A
+        const __m128i bg = _mm_unpacklo_epi8(b, g);
+        const __m128i ra = _mm_unpacklo_epi8(r, alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),     _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x + 4), _mm_unpackhi_epi16(bg, ra));
+    }
+#elif defined(VIDEOCONV_NEON)
+    const int16x8_t rnd = vdupq_n_s16(32);
+    for (; x + 8 <= width; x += 8) {
+        const uint8x8_t u8 = vreinterpret_u8_u32(vld1_dup_u32(reinterpret_cast<const uint32_t*>(u + x / 2)));
+        const uint8x8_t v8 = vreinterpret_u8_u32(vld1_dup_u32(reinterpret_cast<const uint32_t*>(v + x / 2)));
+        // 每个色度样本复制给相邻两个像素
+        const int16x8_t uu = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vzip_u8(u8, u8).val[0])), vdupq_n_s16(128));
+        const int16x8_t vv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vzip_u8(v8, v8).val[0])), vdupq_n_s16(128));
+        const int16x8_t yy = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + x))), vdupq_n_s16(16)), kCy);
+
+        const int16x8_t r = vqaddq_s16(vqaddq_s16(yy, vmulq_n_s16(vv, kCrv)), rnd);
+        const int16x8_t g = vqaddq_s16(vqsubq_s16(vqsubq_s16(yy, vmulq_n_s16(uu, kCgu)), vmulq_n_s16(vv, kCgv)), rnd);
+        const int16x8_t b = vqaddq_s16(vqaddq_s16(yy, vmulq_n_s16(uu, kCbu)), rnd);
+        uint8x8x4_t px;
+        px.val[0] = vqshrun_n_s16(b, 6);
+        px.val[1] = vqshrun_n_s16(g, 6);
+        px.val[2] = vqshrun_n_s16(r, 6);
+        px.val[3] = vdup_n_u8(0xff);
+        vst4_u8(reinterpret_cast<uint8_t*>(dst + x), px);
+    }
+#endif
+    for (; x < width; ++x) dst[x] = pixel(y[x], u[x / 2], v[x / 2]);
+}
+
+// 交错字节拆成奇偶两路：YUYV 拆出 Y 与 UV，NV12 的 UV 拆出 U 与 V
+static void deinterleave(const quint8* src, quint8* even, quint8* odd, int pairs)
+{
+    int i = 0;
+#if defined(VIDEOCONV_SSE2)
+    const __m128i lo = _mm_set1_epi16(0x00ff);
+    for (; i + 16 <= pairs; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(even + i),
+                         _mm_packus_epi16(_mm_and_si128(a, lo), _mm_and_si128(b, lo)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(odd + i),
+                         _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+    }
+#elif defined(VIDEOCONV_NEON)
+    for (; i + 16 <= pairs; i += 16) {
+        const uint8x16x2_t p = vld2q_u8(src + 2 * i);
+        vst1q_u8(even + i, p.val[0]);
+        vst1q_u8(odd + i,  p.val[1]);
+    }
+#endif
+    for (; i < pairs; ++i) { even[i] = src[2 * i]; odd[i] = src[2 * i + 1]; }
+}
+
+// dst = 两行逐字节取平均（向上取整）
+static void avgRows(const quint32* a, const quint32* b, quint32* dst, int n)
+{
+    int i = 0;
+#if defined(VIDEOCONV_SSE2)
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_avg_epu8(x, y));
+    }
+#elif defined(VIDEOCONV_NEON)
+    for (; i + 4 <= n; i += 4) {
+        const uint8x16_t x = vld1q_u8(reinterpret_cast<const uint8_t*>(a + i));
+        const uint8x16_t y = vld1q_u8(reinterpret_cast<const uint8_t*>(b + i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + i), vrhaddq_u8(x, y));
+    }
+#endif
+    for (; i < n; ++i) {
+        const quint32 x = a[i], y = b[i];
+        // 逐字节 (x + y + 1) >> 1，不跨字节进位
+        dst[i] = (x | y) - (((x ^ y) >> 1) & 0x7f7f7f7fu);
+    }
+}
+
+// 水平相邻两像素取平均，输出 outW 个
+static void halveRow(const quint32* src, quint32* dst, int outW)
+{
+    int i = 0;
+#if defined(VIDEOCONV_SSE2)
+    for (; i + 4 <= outW; i += 4) {
+        const __m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i)));
+        const __m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 4)));
+        const __m128i ev = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m128i od = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_avg_epu8(ev, od));
+    }
+#elif defined(VIDEOCONV_NEON)
+    for (; i + 4 <= outW; i += 4) {
+        const uint32x4x2_t p = vld2q_u32(src + 2 * i);
+        vst1q_u32(dst + i, vreinterpretq_u32_u8(vrhaddq_u8(vreinterpretq_u8_u32(p.val[0]),
+                                                           vreinterpretq_u8_u32(p.val[1]))));
+    }
+#endif
+    for (; i < outW; ++i) {
+        const quint32 x = src[2 * i], y = src[2 * i + 1];
+        dst[i] = (x | y) - (((x ^ y) >> 1) & 0x7f7f7f7fu);
+    }
+}
+
+void halveRgb32(const quint32* src, int w, int h, int srcStride, quint32* dst, int dstStride)
+{
+    const int ow = w / 2, oh = h / 2;
+    std::vector<quint32> tmp(size_t(qMax(1, w)));
+    for (int oy = 0; oy < oh; ++oy) {
+        const quint32* a = reinterpret_cast<const quint32*>(reinterpret_cast<const quint8*>(src) + size_t(2 * oy) * srcStride);
+        const quint32* b = reinterpret_cast<const quint32*>(reinterpret_cast<const quint8*>(a) + srcStride);
+        avgRows(a, b, tmp.data(), 2 * ow);
+        halveRow(tmp.data(), reinterpret_cast<quint32*>(reinterpret_cast<quint8*>(dst) + size_t(oy) * dstStride), ow);
+    }
+}
+
+bool toRgb32(const Planes& src, int shift, quint32* dst, int dstStride)
+{
+    const int W = src.width, H = src.height;
+    if (!src.p0 || W <= 0 || H <= 0 || (W & 1) || W > kMaxWidth) return false;
+    if (shift < 0 || shift > kMaxShift) return false;
+    const bool planar = (src.layout == Layout::I420 || src.layout == Layout::YV12);
+    const bool semi   = (src.layout == Layout::NV12 || src.layout == Layout::NV21);
+    if ((planar || semi) && !src.p1) return false;
+    if (planar && !src.p2) return false;
+
+    const int f  = 1 << shift;
+    const int oh = H >> shift;
+    const int hw = W / 2;
+
+    // 行缓冲：Y/U/V 拆分结果（打包格式另需一段交错色度）+ f 行全宽 RGB
+    std::vector<quint8>  yuv(size_t(W) * 3);
+    std::vector<quint32> rgb(size_t(W) * f);
+    quint8* yBuf = yuv.data();
+    quint8* uBuf = yBuf + W;
+    quint8* vBuf = uBuf + hw;
+
+    for (int oy = 0; oy < oh; ++oy) {
+        for (int k = 0; k < f; ++k) {
+            const int sy = oy * f + k;
+            const quint8 *yr = yBuf, *ur = uBuf, *vr = vBuf;
+            switch (src.layout) {
+            case Layout::YUYV:
+            case Layout::UYVY: {
+                const quint8* line = src.p0 + size_t(sy) * src.s0;
+                quint8* cBuf = vBuf + hw;   // 临时存放交错色度
+                if (src.layout == Layout::YUYV) deinterleave(line, yBuf, cBuf, W);
+                else                            deinterleave(line, cBuf, yBuf, W);
+                deinterleave(cBuf, uBuf, vBuf, hw);
+                break;
+            }
+            case Layout::NV12:
+            case Layout::NV21: {
+                yr = src.p0 + size_t(sy) * src.s0;
+                const quint8* uv = src.p1 + size_t(sy / 2) * src.s1;
+                if (src.layout == Layout::NV12) deinterleave(uv, uBuf, vBuf, hw);
+                else                            deinterleave(uv, vBuf, uBuf, hw);
+                break;
+            }
+            case Layout::I420:
+            case Layout::YV12: {
+                yr = src.p0 + size_t(sy) * src.s0;
+                const quint8* c1 = src.p1 + size_t(sy / 2) * src.s1;
+                const quint8* c2 = src.p2 + size_t(sy / 2) * src.s2;
+                ur = (src.layout == Layout::I420) ? c1 : c2;
+                vr = (src.layout == Layout::I420) ? c2 : c1;
+                break;
+            }
+            }
+            yuvRowToRgb32(yr, ur, vr, rgb.data() + size_t(k) * W, W);
+        }
+
+        quint32* out = reinterpret_cast<quint32*>(reinterpret_cast<quint8*>(dst) + size_t(oy) * dstStride);
+        if (shift == 0) {
+            std::memcpy(out, rgb.data(), size_t(W) * 4);
+            continue;
+        }
+        // 先竖直两两合并到第 0 行，再水平逐级减半
+        for (int n = f; n > 1; n /= 2) {
+            for (int k = 0; k < n / 2; ++k)
+                avgRows(rgb.data() + size_t(2 * k) * W, rgb.data() + size_t(2 * k + 1) * W,
+                        rgb.data() + size_t(k) * W, W);
+        }
+        int w = W;
+        for (int s = 0; s < shift; ++s) {
+            quint32* to = (s == shift - 1) ? out : rgb.data();
+            halveRow(rgb.data(), to, w / 2);
+            w /= 2;
+        }
+    }
+    return true;
+}
+
+} // namespace VideoConvert
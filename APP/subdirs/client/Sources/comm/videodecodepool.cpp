@@ -0,0 +1,197 @@
+#include "videodecodepool.h"
+#include <cstring>
+
+struct VideoDecodePool::Lane {
+    QString sender, media;
+    quint64 gen = 0;
+    // 以下三项由 mu_ 保护
+    QVector<Job> pending;
+    bool running = false;
+    bool dead    = false;
+    // 以下只在工作线程访问（同一通道同一时刻只有一个任务）
+    VideoCodec::CrDecoder cr;
+    QImage back;   // UDP 屏幕增量背板
+};
+
+class VideoDecodePool::Task : public QRunnable {
+public:
+    Task(VideoDecodePool* pool, QSharedPointer<Lane> lane) : pool_(pool), lane_(std::move(lane)) {}
+    void run() override { pool_->drain(lane_); }
+private:
+    VideoDecodePool* pool_;
+    QSharedPointer<Lane> lane_;
+};
+
+VideoDecodePool::VideoDecodePool(QObject* parent) : QObject(parent)
+{
+    // 留一个核给 GUI 和音频
+    pool_.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 4));
+    pool_.setExpiryTimeout(30000);
+}
+
+VideoDecodePool::~VideoDecodePool()
+{
+    clear();
+    pool_.waitForDone();
+}
+
+void VideoDecodePool::submitPacket(const QString& sender, const QString& media, const QJsonObject& j,
+                                   const QByteArray& bin, const QSize& target)
+{
+    Job job;
+    job.kind   = (media == "screen") ? Kind::Jpeg : Kind::Cr;
+    job.json   = j;
+    job.bin    = bin;
+    job.target = target;
+    enqueue(sender, media, std::move(job));
+}
+
+void VideoDecodePool::submitScreenJpeg(const QString& sender, const QByteArray& jpeg)
+{
+    Job job;
+    job.kind = Kind::UdpJpeg;
+    job.bin  = jpeg;
+    enqueue(sender, QStringLiteral("screen"), std::move(job));
+}
+
+void VideoDecodePool::submitScreenDelta(const QString& sender, const QByteArray& blob, int w, int h)
+{
+    Job job;
+    job.kind = Kind::Ds01;
+    job.bin  = blob;
+    job.w = w; job.h = h;
+    enqueue(sender, QStringLiteral("screen"), std::move(job));
+}
+
+void VideoDecodePool::removeSender(const QString& sender, const QString& media)
+{
+    QMutexLocker lk(&mu_);
+    for (auto it = lanes_.begin(); it != lanes_.end(); ) {
+        const Lane& l = *it.value();
+        if (l.sender == sender && (media.isEmpty() || l.media == media)) {
+            it.value()->dead = true;
+            it.value()->pending.clear();
+            it = lanes_.erase(it);
+        } else ++it;
+    }
+}
+
+void VideoDecodePool::clear()
+{
+    QMutexLocker lk(&mu_);
+    for (auto& l : lanes_) { l->dead = true; l->pending.clear(); }
+    lanes_.clear();
+}
+
+bool VideoDecodePool::isCurrent(const QString& sender, const QString& media, quint64 gen) const
+{
+    QMutexLocker lk(&mu_);
+    const QSharedPointer<Lane> lane = lanes_.value(sender + '\n' + media);
+    return lane && lane->gen == gen;
+}
+
+void VideoDecodePool::enqueue(const QString& sender, const QString& media, Job job)
+{
+    QMutexLocker lk(&mu_);
+    QSharedPointer<Lane>& lane = lanes_[sender + '\n' + media];
+    if (!lane) {
+        lane = QSharedPointer<Lane>::create();
+        lane->sender = sender;
+        lane->media  = media;
+        lane->gen    = ++nextGen_;
+    }
+
+    auto isCrDelta = [](const Job& x){
+        return x.kind == Kind::Cr && x.json.value("frame").toString() == "delta";
+    };
+    if (job.kind == Kind::Ds01) {
+        // 累积增量：保留排队中的全部帧
+    } else if (isCrDelta(job)) {
+        for (int i = lane->pending.size() - 1; i >= 0; --i)
+            if (isCrDelta(lane->pending[i])) lane->pending.remove(i);
+    } else {
+        lane->pending.clear();
+    }
+    lane->pending.append(std::move(job));
+
+    if (!lane->running) {
+        lane->running = true;
+        pool_.start(new Task(this, lane));
+    }
+}
+
+void VideoDecodePool::drain(const QSharedPointer<Lane>& lane)
+{
+    for (;;) {
+        QVector<Job> jobs;
+        {
+            QMutexLocker lk(&mu_);
+            if (lane->dead || lane->pending.isEmpty()) { lane->running = false; return; }
+            jobs.swap(lane->pending);
+        }
+
+        QImage last;
+        for (const Job& job : jobs) {
+            QImage img;
+            if (decode(*lane, job, &img)) last = img;
+        }
+        if (last.isNull()) continue;
+
+        QMutexLocker lk(&mu_);
+        if (!lane->dead) emit frameDecoded(lane->sender, lane->media, last, lane->gen);
+    }
+}
+
+bool VideoDecodePool::decode(Lane& lane, const Job& job, QImage* out)
+{
+    switch (job.kind) {
+    case Kind::Jpeg:
+        *out = VideoCodec::decodeJpeg(job.bin, job.target);
+        return !out->isNull();
+    case Kind::Cr:
+        return lane.cr.decode(job.json, job.bin, out, job.target);
+    case Kind::UdpJpeg:
+        *out = VideoCodec::decodeJpeg(job.bin);
+        if (out->isNull()) return false;
+        lane.back = *out;   // 同步背板
+        return true;
+    case Kind::Ds01:
+        if (!applyDs01(lane.back, job.bin, job.w, job.h)) return false;
+        *out = lane.back;   // 隐式共享：下一次套用增量时背板自行分离
+        return true;
+    }
+    return false;
+}
+
+// DS01：u32 magic, u16 count, count x (u16 x, u16 y, u16 w, u16 h, u32 clen, [qCompress RGB32])
+bool VideoDecodePool::applyDs01(QImage& back, const QByteArray& blob, int w, int h)
+{
+    if (w <= 0 || h <= 0) return false;
+    if (back.isNull() || back.size() != QSize(w, h)) {
+        back = QImage(w, h, QImage::Format_RGB32);
+        back.fill(Qt::black);
+    }
+
+    QDataStream ds(blob);
+    ds.setByteOrder(QDataStream::BigEndian);
+    quint32 magic = 0; quint16 rectCount = 0;
+    ds >> magic >> rectCount;
+    if (magic != 0x44533031) return false; // 'DS01'
+
+    for (int i = 0; i < rectCount; ++i) {
+        quint16 x = 0, y = 0, rw = 0, rh = 0; quint32 clen = 0;
+        ds >> x >> y >> rw >> rh >> clen;
+        if (ds.status() != QDataStream::Ok) break;
+        if (ds.device()->bytesAvailable() < qint64(clen)) break;
+        QByteArray comp; comp.resize(int(clen));
+        ds.readRawData(comp.data(), int(clen));
+        if (x + rw > w || y + rh > h) continue;
+        const QByteArray raw = qUncompress(comp);
+        if (raw.size() != int(rw) * int(rh) * 4) continue;
+
+        const char* src = raw.constData();
+        for (int row = 0; row < rh; ++row)
+            std::memcpy(back.scanLine(y + row) + x * 4, src + row * rw * 4, size_t(rw) * 4);
+    }
+    return true;
+}
@@ -3,12 +3,11 @@
 #include "regist.h"
 #include "client_factory.h"
 #include "client_expert.h"
+#include "apiclient.h"
 
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMessageBox>
-#include <QHostAddress>
-#include <QTcpSocket>
 #include <QCloseEvent>
 #include <QCoreApplication>
 #include <QStyle>
@@ -157,36 +156,6 @@ QString Login::selectedRole() const
     }
 }
 
-bool Login::sendRequest(const QJsonObject &obj, QJsonObject &reply, QString *errMsg)
-{
-    QTcpSocket sock;
-    sock.connectToHost(QHostAddress(QString::fromLatin1(SERVER_HOST)), SERVER_PORT);
-    if (!sock.waitForConnected(3000)) {
-        if (errMsg) *errMsg = "服务器连接失败";
-        return false;
-    }
-    const QByteArray line = QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n";
-    if (sock.write(line) == -1 || !sock.waitForBytesWritten(2000)) {
-        if (errMsg) *errMsg = "请求发送失败";
-        return false;
-    }
-    if (!sock.waitForReadyRead(5000)) {
-        if (errMsg) *errMsg = "服务器无响应";
-        return false;
-    }
-    QByteArray resp = sock.readAll();
-    int nl = resp.indexOf('\n');
-    if (nl >= 0) resp = resp.left(nl);
-    QJsonParseError pe{};
-    QJsonDocument rdoc = QJsonDocument::fromJson(resp, &pe);
-    if (pe.error != QJsonParseError::NoError || !rdoc.isObject()) {
-        if (errMsg) *errMsg = "响应解析失败";
-        return false;
-    }
-    reply = rdoc.object();
-    return true;
-}
-
 void Login::on_btnLogin_clicked()
 {
     const QString username = ui->leUsername->text().trimmed();
@@ -207,25 +176,26 @@ void Login::on_btnLogin_clicked()
         {"username",username},
         {"password",password}
     };
-    QJsonObject rep;
-    QString err;
-    if (!sendRequest(req, rep, &err)) {
-        QMessageBox::warning(this, "登录失败", err);
-        return;
-    }
-    if (!rep.value("ok").toBool(false)) {
-        QMessageBox::warning(this, "登录失败", rep.value("msg").toString("未知错误"));
-        return;
-    }
+    // 异步请求：等待应答期间界面照常响应，只禁用登录按钮防重复提交
+    ui->btnLogin->setEnabled(false);
+    ApiClient* api = ApiClient::instance();
+    api->setServer(QString::fromLatin1(SERVER_HOST), SERVER_PORT);
+    api->call(req, this, [this, role](const QJsonObject& rep){
+        ui->btnLogin->setEnabled(true);
+        if (!rep.value("ok").toBool(false)) {
+            QMessageBox::warning(this, "登录失败", rep.value("msg").toString("未知错误"));
+            return;
+        }
 
-    if (role == "expert") {
-        if (!expertWin) expertWin = new ClientExpert;
-        expertWin->show();
-    } else {
-        if (!factoryWin) factoryWin = new ClientFactory;
-        factoryWin->show();
-    }
-    this->hide();
+        if (role == "expert") {
+            if (!expertWin) expertWin = new ClientExpert;
+            expertWin->show();
+        } else {
+            if (!factoryWin) factoryWin = new ClientFactory;
+            factoryWin->show();
+        }
+        this->hide();
+    });
 }
 
 void Login::on_btnToReg_clicked()
@@ -0,0 +1,94 @@
+#include "orderfeed.h"
+#include "comm/apiclient.h"
+
+#include <QJsonArray>
+
+OrderFeed::OrderFeed(QObject* parent) : QObject(parent)
+{
+    retry_.setSingleShot(true);
+    retry_.setInterval(kRetryMs);
+    connect(&retry_, &QTimer::timeout, this, &OrderFeed::subscribe);
+}
+
+void OrderFeed::start(const QString& role, const QString& username)
+{
+    role_ = role;
+    user_ = username;
+    ApiClient* api = ApiClient::instance();
+    connect(api, &ApiClient::pushed, this, &OrderFeed::onPushed, Qt::UniqueConnection);
+    connect(api, &ApiClient::connectionLost, this, [this](){
+        live_ = false;
+        retry_.start();
+    }, Qt::UniqueConnection);
+    subscribe();
+}
+
+void OrderFeed::subscribe()
+{
+    if (req_) return;
+    retry_.stop();
+    live_ = false;
+
+    QJsonObject req{
+        {"action", "subscribe_orders"},
+        {"role", role_},
+        {"username", user_}
+    };
+    if (synced_) req["since"] = double(seq_);   // 0 也照发：不带 since 服务端才当新订阅
+    const bool wasFirst = first_;
+    first_ = false;
+
+    req_ = ApiClient::instance()->call(req, this, [this, wasFirst](const QJsonObject& rep){
+        req_ = 0;
+        if (!rep.value("ok").toBool()) {
+            retry_.start();
+            return;
+        }
+        live_ = true;
+        const qint64 seq = qint64(rep.value("seq").toDouble());
+        // 没有可续的 seq（之前从未订阅成功）或服务端补不了：界面上的数据可能已旧，整体重载
+        if (rep.value("reset").toBool() || (!synced_ && !wasFirst)) {
+            seq_ = seq;
+            synced_ = true;
+            emit resync();
+            return;
+        }
+        for (const QJsonValue& v : rep.value("changes").toArray()) {
+            const QJsonObject ch = v.toObject();
+            emit changed(ch.value("op").toString(), ch.value("order").toObject());
+        }
+        seq_ = qMax(seq_, seq);
+        synced_ = true;
+    });
+}
+
+void OrderFeed::onPushed(const QJsonObject& ev)
+{
+    const QString kind = ev.value("event").toString();
+    if (kind == "orders_reset") {
+        seq_ = qint64(ev.value("seq").toDouble());
+        synced_ = true;
+        emit resync();
+        return;
+    }
+    if (kind != "order_change" || !live_) return;
+
+    const qint64 seq = qint64(ev.value("seq").toDouble());
+    if (seq <= seq_) return;
+    if (qint64(ev.value("prev").toDouble()) != seq_) {
+        // 中间漏了：从已应用的位置重新订阅，服务端补发缺口
+        subscribe();
+        return;
+    }
+    seq_ = seq;
+    emit changed(ev.value("op").toString(), ev.value("order").toObject());
+}
+
+bool OrderFeed::matches(const QJsonObject& order, const QString& keyword, const QString& status)
+{
+    if (!status.isEmpty() && status != QStringLiteral("全部") && order.value("status").toString() != status)
+        return false;
+    if (keyword.isEmpty()) return true;
+    return order.value("title").toString().contains(keyword, Qt::CaseInsensitive)
+        || order.value("desc").toString().contains(keyword, Qt::CaseInsensitive);
+}
@@ -0,0 +1,80 @@
+#include "orderpager.h"
+#include "comm/apiclient.h"
+
+#include <QAbstractScrollArea>
+#include <QScrollBar>
+#include <QTimer>
+
+OrderPager::OrderPager(QObject* parent) : QObject(parent) {}
+
+void OrderPager::watch(QAbstractScrollArea* view)
+{
+    view_ = view;
+    connect(view->verticalScrollBar(), &QScrollBar::valueChanged, this, &OrderPager::maybeFetch);
+    connect(view->verticalScrollBar(), &QScrollBar::rangeChanged, this, &OrderPager::maybeFetch);
+}
+
+void OrderPager::reset(const QJsonObject& query)
+{
+    if (req_) ApiClient::instance()->cancel(req_);
+    req_ = 0;
+    query_ = query;
+    next_ = 0;
+    nextRank_ = 0;
+    ranked_ = false;
+    more_ = true;
+    first_ = true;
+    fetchMore();
+}
+
+void OrderPager::fetchMore()
+{
+    if (req_ || !more_) return;
+    QJsonObject req = query_;
+    req["limit"] = kPageSize;
+    if (!first_) {
+        req["after"] = next_;
+        if (ranked_) req["after_rank"] = nextRank_;
+    }
+
+    req_ = ApiClient::instance()->call(req, this, [this](const QJsonObject& rep){
+        req_ = 0;
+        if (!rep.value("ok").toBool()) {
+            more_ = false;
+            emit failed(rep.value("msg").toString(QStringLiteral("服务器响应异常")));
+            releaseDeferred();
+            return;
+        }
+        more_ = rep.contains("next");
+        next_ = rep.value("next").toDouble();
+        ranked_ = rep.contains("next_rank");
+        nextRank_ = rep.value("next_rank").toDouble();
+        const bool first = first_;
+        first_ = false;
+        emit pageArrived(rep.value("orders").toArray(), first);
+        releaseDeferred();   // 变更都晚于（或等于）该页的快照，盖在页上面才是最新状态
+        // 行数还撑不出滚动条时收不到滚动事件，等表格排好版再看一次
+        QTimer::singleShot(0, this, &OrderPager::maybeFetch);
+    });
+}
+
+bool OrderPager::defer(const QString& op, const QJsonObject& order)
+{
+    if (!req_) return false;
+    deferred_.append(qMakePair(op, order));
+    return true;
+}
+
+void OrderPager::releaseDeferred()
+{
+    QVector<QPair<QString, QJsonObject>> held;
+    held.swap(deferred_);
+    for (const auto& ch : held) emit deferredChange(ch.first, ch.second);
+}
+
+void OrderPager::maybeFetch()
+{
+    if (!view_ || req_ || !more_) return;
+    const QScrollBar* sb = view_->verticalScrollBar();
+    if (sb->maximum() - sb->value() <= sb->pageStep()) fetchMore();
+}
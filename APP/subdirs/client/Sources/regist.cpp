@@ -1,12 +1,11 @@
 #include "regist.h"
 #include "ui_regist.h"
 #include "login.h"
+#include "apiclient.h"
 
-#include <QTcpSocket>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QMessageBox>
-#include <QHostAddress>
 #include <QComboBox>
 #include <QLineEdit>
 #include <QRegularExpression>
@@ -160,37 +159,6 @@ QString Regist::selectedRole() const
     }
 }
 
-bool Regist::sendRequest(const QJsonObject &obj, QJsonObject &reply, QString *errMsg)
-{
-    QTcpSocket sock;
-    sock.connectToHost(QHostAddress(QString::fromLatin1(SERVER_HOST)), SERVER_PORT);
-    if (!sock.waitForConnected(3000)) {
-        if (errMsg) *errMsg = "服务器连接失败";
-        return false;
-    }
-    const QByteArray line = QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n";
-    if (sock.write(line) == -1 || !sock.waitForBytesWritten(2000)) {
-        if (errMsg) *errMsg = "请求发送失败";
-        return false;
-    }
-    if (!sock.waitForReadyRead(5000)) {
-        if (errMsg) *errMsg = "服务器无响应";
-        return false;
-    }
-    QByteArray resp = sock.readAll();
-    int nl = resp.indexOf('\n');
-    if (nl >= 0) resp = resp.left(nl);
-
-    QJsonParseError pe{};
-    QJsonDocument rdoc = QJsonDocument::fromJson(resp, &pe);
-    if (pe.error != QJsonParseError::NoError || !rdoc.isObject()) {
-        if (errMsg) *errMsg = "响应解析失败";
-        return false;
-    }
-    reply = rdoc.object();
-    return true;
-}
-
 void Regist::on_btnRegister_clicked()
 {
     const QString username = ui->leUsername->text().trimmed();
@@ -224,20 +192,20 @@ void Regist::on_btnRegister_clicked()
         {"username",username},
         {"password",password}
     };
-    QJsonObject rep;
-    QString err;
-    if (!sendRequest(req, rep, &err)) {
-        QMessageBox::warning(this, "注册失败", err);
-        return;
-    }
-    if (!rep.value("ok").toBool(false)) {
-        QMessageBox::warning(this, "注册失败", rep.value("msg").toString("未知错误"));
-        return;
-    }
+    ui->btnRegister->setEnabled(false);
+    ApiClient* api = ApiClient::instance();
+    api->setServer(QString::fromLatin1(SERVER_HOST), SERVER_PORT);
+    api->call(req, this, [this, username, role](const QJsonObject& rep){
+        ui->btnRegister->setEnabled(true);
+        if (!rep.value("ok").toBool(false)) {
+            QMessageBox::warning(this, "注册失败", rep.value("msg").toString("未知错误"));
+            return;
+        }
 
-    QMessageBox::information(this, "注册成功", "账号初始化完成");
-    emit registered(username, role);
-    close(); // 关闭注册窗口
+        QMessageBox::information(this, "注册成功", "账号初始化完成");
+        emit registered(username, role);
+        close(); // 关闭注册窗口
+    });
 }
 
 void Regist::on_btnBack_clicked()
@@ -18,6 +18,8 @@ INCLUDEPATH += Resources
 HEADERS += \
     Headers/client_factory.h \
     Headers/client_expert.h \
+    Headers/orderpager.h \
+    Headers/orderfeed.h \
     Headers/comm/devicepanel.h \
     Headers/comm/kb_client.h \
     Headers/comm/knowledge_panel.h \
@@ -30,14 +32,26 @@ HEADERS += \
     Headers/comm/annot.h \
     Headers/comm/annotcanvas.h \
     Headers/comm/audiochat.h \
+    Headers/comm/jitterbuffer.h \
+    Headers/comm/audiodsp.h \
+    Headers/comm/audiocodec.h \
+    Headers/comm/audioring.h \
     Headers/comm/clientconn.h \
+    Headers/comm/apiclient.h \
+    Headers/comm/roomroster.h \
     Headers/comm/screenshare.h \
+    Headers/comm/camerapipeline.h \
+    Headers/comm/videoconvert.h \
+    Headers/comm/videocodec.h \
+    Headers/comm/videodecodepool.h \
     Headers/comm/udpmedia.h \
     Headers/comm/volume_popup.h
 
 SOURCES += \
     Sources/client_factory.cpp \
     Sources/client_expert.cpp \
+    Sources/orderpager.cpp \
+    Sources/orderfeed.cpp \
     Sources/comm/devicepanel.cpp \
     Sources/comm/kb_client.cpp \
     Sources/comm/knowledge_panel.cpp \
@@ -51,8 +65,17 @@ SOURCES += \
     Sources/comm/annot.cpp \
     Sources/comm/annotcanvas.cpp \
     Sources/comm/audiochat.cpp \
+    Sources/comm/jitterbuffer.cpp \
+    Sources/comm/audiodsp.cpp \
+    Sources/comm/audiocodec.cpp \
     Sources/comm/clientconn.cpp \
+    Sources/comm/apiclient.cpp \
+    Sources/comm/roomroster.cpp \
     Sources/comm/screenshare.cpp \
+    Sources/comm/camerapipeline.cpp \
+    Sources/comm/videoconvert.cpp \
+    Sources/comm/videocodec.cpp \
+    Sources/comm/videodecodepool.cpp \
     Sources/comm/udpmedia.cpp \
     Sources/comm/volume_popup.cpp
 
@@ -1,10 +1,11 @@
 TEMPLATE = subdirs
 CONFIG += ordered
 
-SUBDIRS += client server
+SUBDIRS += client server bench
 
 client.file = client/client.pro
 server.file = server/server.pro
+bench.file  = bench/bench.pro
 
 # 如果存在先后依赖（一般不需要），可启用：
 # server.depends =
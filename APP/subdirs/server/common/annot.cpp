@@ -1,6 +1,7 @@
 #include "annot.h"
 #include <QtGlobal>
 #include <cmath>
+#include <algorithm>
 
 static inline QString toLower(const QString& s){ auto t=s; t.detach(); return t.toLower(); }
 
@@ -13,6 +14,16 @@ AnnotModel::Tool AnnotModel::toolFromString(const QString& s) {
     return Pen;
 }
 
+QString AnnotModel::toolName(Tool t) {
+    switch (t) {
+    case Rect:    return "rect";
+    case Ellipse: return "ellipse";
+    case Arrow:   return "arrow";
+    case Text:    return "text";
+    default:      return "pen";
+    }
+}
+
 void AnnotModel::drawArrow(QPainter& p, const QPointF& a, const QPointF& b, int width, const QColor& color)
 {
     QPen pen(color, width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
@@ -22,8 +33,8 @@ void AnnotModel::drawArrow(QPainter& p, const QPointF& a, const QPointF& b, int
     const QLineF line(a, b);
     if (line.length() < 1.0) return;
 
-    const double ah = qMax<double>(8.0, double(width) * 3.0);
-    const double aw = qMax<double>(6.0, double(width) * 2.0);
+    const double ah = qMax<double>(8.0, double(width) * 3.0); // 箭头长度
+    const double aw = qMax<double>(6.0, double(width) * 2.0); // 箭头半宽
     const double angle = std::atan2(line.dy(), line.dx());
     const QPointF tip = b;
 
@@ -37,29 +48,90 @@ void AnnotModel::drawArrow(QPainter& p, const QPointF& a, const QPointF& b, int
     p.drawPolygon(tri);
 }
 
+// 包围盒合并；单点的包围盒宽高为 0，QRectF::united 会把它当空矩形忽略
+static QRectF unite(const QRectF& a, const QRectF& b)
+{
+    return QRectF(QPointF(qMin(a.left(), b.left()),   qMin(a.top(), b.top())),
+                  QPointF(qMax(a.right(), b.right()), qMax(a.bottom(), b.bottom())));
+}
+
 bool AnnotModel::undoLastByOwner(const QString& owner)
 {
-    if (order_.isEmpty()) return false;
-    for (int i = order_.size() - 1; i >= 0; --i) {
-        const QString& id = order_.at(i);
-        auto it = strokes_.find(id);
-        if (it != strokes_.end() && it->owner == owner) {
-            strokes_.erase(it);
-            order_.removeAt(i);
-            return true;
-        }
+    auto it = undo_.find(owner);
+    if (it == undo_.end()) return false;
+    QVector<int>& stack = it.value();
+    while (!stack.isEmpty()) {
+        const int h = stack.takeLast();
+        if (store_[h].alive) { kill(h); return true; }
     }
     return false;
 }
 
-bool AnnotModel::applyEvent(const QJsonObject& e)
+QVector<QPair<QJsonObject, QByteArray>> AnnotModel::snapshotEvents() const
+{
+    QVector<QPair<QJsonObject, QByteArray>> out;
+    for (int h : order_) {
+        const Stroke& s = store_[h];
+        if (!s.alive) continue;
+        QJsonObject begin{
+            {"op", "begin"},
+            {"id", s.id},
+            {"sender", s.owner},
+            {"tool", toolName(s.tool)},
+            {"color", s.color.name(QColor::HexRgb)},
+            {"width", s.width}
+        };
+        if (!s.text.isEmpty()) begin["text"] = s.text;
+        out.append(qMakePair(begin, packPoints(s.pts)));
+        if (s.finished)
+            out.append(qMakePair(QJsonObject{{"op", "end"}, {"id", s.id}, {"sender", s.owner}}, QByteArray()));
+    }
+    return out;
+}
+
+QByteArray AnnotModel::packPoints(const QVector<QPointF>& pts)
+{
+    QByteArray bin(pts.size() * 4, Qt::Uninitialized);
+    uchar* d = reinterpret_cast<uchar*>(bin.data());
+    for (const QPointF& p : pts) {
+        qToBigEndian(quint16(qRound(qBound(0.0, p.x(), 1.0) * 65535.0)), d);
+        qToBigEndian(quint16(qRound(qBound(0.0, p.y(), 1.0) * 65535.0)), d + 2);
+        d += 4;
+    }
+    return bin;
+}
+
+QVector<QPointF> AnnotModel::unpackPoints(const QByteArray& bin)
+{
+    QVector<QPointF> pts;
+    const int n = bin.size() / 4;
+    pts.reserve(n);
+    const uchar* d = reinterpret_cast<const uchar*>(bin.constData());
+    for (int i = 0; i < n; ++i, d += 4)
+        pts << QPointF(qFromBigEndian<quint16>(d) / 65535.0, qFromBigEndian<quint16>(d + 2) / 65535.0);
+    return pts;
+}
+
+static void appendJsonPoints(QVector<QPointF>& pts, const QJsonArray& arr)
+{
+    for (auto v : arr) {
+        auto a = v.toArray();
+        if (a.size() >= 2) pts << QPointF(a[0].toDouble(), a[1].toDouble());
+    }
+}
+
+bool AnnotModel::applyEvent(const QJsonObject& e, const QByteArray& bin)
 {
     const QString op = e.value("op").toString();
-    if (op == "clear") { clear(); return true; }
+    if (op == "clear") {
+        clear();
+        return true;
+    }
     if (op == "undo") {
         const QString who = e.value("sender").toString();
         return undoLastByOwner(who);
     }
+
     const QString id = e.value("id").toString();
     if (id.isEmpty()) return false;
 
@@ -70,85 +142,385 @@ bool AnnotModel::applyEvent(const QJsonObject& e)
         s.tool  = toolFromString(e.value("tool").toString());
         s.color = QColor(e.value("color").toString("#FF0000"));
         s.width = qBound(1, e.value("width").toInt(3), 30);
-        for (auto v : e.value("pts").toArray()) {
-            auto a = v.toArray();
-            if (a.size() >= 2) s.pts << QPointF(a[0].toDouble(), a[1].toDouble());
-        }
         s.text = e.value("text").toString();
-        strokes_.insert(id, s);
-        order_.removeAll(id);
-        order_.push_back(id);
+        // 重复 id：旧笔画打墓碑，新笔画排到最后
+        const int old = byId_.value(id, -1);
+        if (old >= 0) kill(old);
+        const int h = newStroke(s);
+        store_[h].lastMs = QDateTime::currentMSecsSinceEpoch();
+        // 初始点
+        QVector<QPointF> pts;
+        if (!bin.isEmpty()) pts = unpackPoints(bin);
+        else appendJsonPoints(pts, e.value("pts").toArray());
+        grow(h, pts);
         return true;
     } else if (op == "update") {
-        auto it = strokes_.find(id);
-        if (it == strokes_.end()) return false;
-        for (auto v : e.value("pts").toArray()) {
-            auto a = v.toArray();
-            if (a.size() >= 2) it->pts << QPointF(a[0].toDouble(), a[1].toDouble());
+        const int h = byId_.value(id, -1);
+        if (h < 0) return false;
+        QVector<QPointF> pts;
+        if (!bin.isEmpty()) pts = unpackPoints(bin);
+        else appendJsonPoints(pts, e.value("pts").toArray());
+        const QRectF oldB = store_[h].bounds;
+        const bool hadOld = store_[h].hasBounds;
+        store_[h].lastMs = QDateTime::currentMSecsSinceEpoch();
+        grow(h, pts);
+        // 结束后又追加点（乱序事件）：已缓存的笔画变了，新旧包围盒都要修补
+        // （图形按首末点重算包围盒，可能比原来小，旧范围里的像素也要擦掉）
+        const Stroke& s = store_[h];
+        if (s.finished && s.hasBounds) {
+            noteErased(s.bounds, padPx(s));
+            if (hadOld && oldB != s.bounds) noteErased(oldB, padPx(s));
         }
         return true;
     } else if (op == "end") {
-        auto it = strokes_.find(id);
-        if (it == strokes_.end()) return false;
-        it->finished = true;
+        const int h = byId_.value(id, -1);
+        if (h < 0) return false;
+        finish(h);
         return true;
     }
     return false;
 }
 
+void AnnotModel::finish(int h)
+{
+    Stroke& s = store_[h];
+    if (!s.finished && s.hasBounds) {
+        indexCells(h, QRectF(), false);
+        touch(s.bounds);
+    }
+    s.finished = true;
+}
+
+int AnnotModel::finishOwner(const QString& owner)
+{
+    // finishedPrefix 之前的笔画都已结束（或已撤销），只需从扫描位置往后找
+    int n = 0;
+    for (int i = finishedPrefix(); i < order_.size(); ++i) {
+        const int h = order_[i];
+        const Stroke& s = store_[h];
+        if (s.alive && !s.finished && s.owner == owner) { finish(h); ++n; }
+    }
+    return n;
+}
+
+int AnnotModel::finishIdle(qint64 idleMs)
+{
+    const qint64 cutoff = QDateTime::currentMSecsSinceEpoch() - idleMs;
+    int n = 0;
+    for (int i = finishedPrefix(); i < order_.size(); ++i) {
+        const int h = order_[i];
+        const Stroke& s = store_[h];
+        if (s.alive && !s.finished && s.lastMs <= cutoff) { finish(h); ++n; }
+    }
+    return n;
+}
+
+int AnnotModel::newStroke(Stroke s)
+{
+    const int h = store_.size();
+    s.pos = order_.size();
+    s.alive = true;
+    s.hasBounds = false;
+    s.pts.clear();
+    byId_.insert(s.id, h);
+    undo_[s.owner].append(h);
+    maxPad_ = qMax(maxPad_, padPx(s));
+    store_.append(std::move(s));
+    order_.append(h);
+    ++live_;
+    return h;
+}
+
+void AnnotModel::kill(int h)
+{
+    Stroke& s = store_[h];
+    if (!s.alive) return;
+    s.alive = false;
+    if (byId_.value(s.id, -1) == h) byId_.remove(s.id);
+    if (s.hasBounds) {
+        noteErased(s.bounds, padPx(s));
+        touch(s.bounds);
+    }
+    s.pts = QVector<QPointF>();
+    --live_;
+    ++dead_;
+    if (dead_ >= kCompactMin && dead_ > live_) compact();
+}
+
+void AnnotModel::grow(int h, const QVector<QPointF>& pts)
+{
+    if (pts.isEmpty()) return;
+    Stroke& s = store_[h];
+    const QRectF oldB = s.bounds;
+    const bool hadOld = s.hasBounds;
+
+    QRectF seg;   // 本次新增的线段范围（含上一批末点），用于局部重绘
+    double x0 = pts[0].x(), y0 = pts[0].y(), x1 = x0, y1 = y0;
+    if (!s.pts.isEmpty()) {
+        x0 = qMin(x0, s.pts.last().x()); x1 = qMax(x1, s.pts.last().x());
+        y0 = qMin(y0, s.pts.last().y()); y1 = qMax(y1, s.pts.last().y());
+    }
+    for (const QPointF& p : pts) {
+        x0 = qMin(x0, p.x()); x1 = qMax(x1, p.x());
+        y0 = qMin(y0, p.y()); y1 = qMax(y1, p.y());
+    }
+    s.pts += pts;
+
+    if (s.tool == Text) {
+        s.bounds = QRectF(0, 0, 1, 1);   // 文字宽度依赖字体，按整幅处理
+    } else if (s.tool != Pen) {
+        // 图形只用首点和末点：旧的末点不再出现，包围盒按首末点重算（局部重绘仍覆盖旧范围）
+        const QPointF a = s.pts.first(), b = s.pts.last();
+        s.bounds = QRectF(QPointF(qMin(a.x(), b.x()), qMin(a.y(), b.y())),
+                          QPointF(qMax(a.x(), b.x()), qMax(a.y(), b.y())));
+        seg = hadOld ? unite(s.bounds, oldB) : s.bounds;
+    } else {
+        seg = QRectF(QPointF(x0, y0), QPointF(x1, y1));
+        s.bounds = hadOld ? unite(oldB, seg) : seg;
+    }
+    s.hasBounds = true;
+    if (s.tool == Text) seg = s.bounds;
+    touch(seg);
+    if (s.finished) indexCells(h, oldB, hadOld);
+}
+
+// 只有进了缓存层的（已结束）笔画需要索引：结束时整体登记，之后包围盒扩大再补登新覆盖的格子
+// 包围盒缩小时旧格子里的句柄留着，查询时再按包围盒过滤
+void AnnotModel::indexCells(int h, const QRectF& oldB, bool hadOld)
+{
+    const QRectF& b = store_[h].bounds;
+    auto cell = [](double v){ return qBound(0, int(v * kGrid), int(kGrid) - 1); };
+    const int cx0 = cell(b.left()), cx1 = cell(b.right()), cy0 = cell(b.top()), cy1 = cell(b.bottom());
+    const int ox0 = hadOld ? cell(oldB.left())   : 1,
+              ox1 = hadOld ? cell(oldB.right())  : 0,
+              oy0 = hadOld ? cell(oldB.top())    : 1,
+              oy1 = hadOld ? cell(oldB.bottom()) : 0;
+    for (int cy = cy0; cy <= cy1; ++cy)
+        for (int cx = cx0; cx <= cx1; ++cx)
+            if (!(cx >= ox0 && cx <= ox1 && cy >= oy0 && cy <= oy1)) cells_[cy * kGrid + cx].append(h);
+}
+
+QVector<int> AnnotModel::query(const QRectF& n) const
+{
+    auto cell = [](double v){ return qBound(0, int(v * kGrid), int(kGrid) - 1); };
+    QVector<int> out;
+    for (int cy = cell(n.top()); cy <= cell(n.bottom()); ++cy)
+        for (int cx = cell(n.left()); cx <= cell(n.right()); ++cx)
+            for (int h : cells_[cy * kGrid + cx]) {
+                const Stroke& s = store_[h];
+                if (!s.alive || !s.hasBounds) continue;
+                const QRectF& b = s.bounds;
+                if (b.right() < n.left() || b.left() > n.right() || b.bottom() < n.top() || b.top() > n.bottom()) continue;
+                out.append(h);
+            }
+    std::sort(out.begin(), out.end(), [this](int a, int b){ return store_[a].pos < store_[b].pos; });
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+void AnnotModel::touch(const QRectF& n)
+{
+    dirty_ = hasDirty_ ? unite(dirty_, n) : n;
+    hasDirty_ = true;
+}
+
+QRect AnnotModel::takeDirty(const QSize& size)
+{
+    if (!hasDirty_) return QRect();
+    hasDirty_ = false;
+    return pixelRect(dirty_, maxPad_, size);
+}
+
+// 整理：丢掉墓碑，句柄和位置重新连续编号；缓存层整体重画
+void AnnotModel::noteErased(const QRectF& n, int pad)
+{
+    // 各缓存层都已修补过的前缀直接丢掉；仍然积压太多（有的层很久没画）就让缓存整体重画
+    int done = erased_.size();
+    for (const Layer& L : layers_)
+        if (L.rev == rev_) done = qMin(done, L.erased);
+    if (done > 0) {
+        erased_.remove(0, done);
+        for (Layer& L : layers_)
+            if (L.rev == rev_) L.erased -= done;
+    }
+    if (erased_.size() >= kMaxErased) { invalidate(); return; }
+    erased_.append(qMakePair(n, pad));
+}
+
+void AnnotModel::compact()
+{
+    QVector<Stroke> store;
+    store.reserve(live_);
+    QVector<int> remap(store_.size(), -1);
+    for (int h : order_) {
+        if (!store_[h].alive) continue;
+        remap[h] = store.size();
+        store.append(std::move(store_[h]));
+        store.last().pos = remap[h];
+    }
+    store_ = std::move(store);
+    order_.resize(store_.size());
+    byId_.clear();
+    for (auto& c : cells_) c.clear();
+    maxPad_ = 0;
+    for (int h = 0; h < store_.size(); ++h) {
+        order_[h] = h;
+        byId_.insert(store_[h].id, h);
+        maxPad_ = qMax(maxPad_, padPx(store_[h]));
+        if (store_[h].finished && store_[h].hasBounds) indexCells(h, QRectF(), false);
+    }
+    for (auto it = undo_.begin(); it != undo_.end(); ) {
+        QVector<int> stack;
+        for (int h : it.value()) if (remap[h] >= 0) stack.append(remap[h]);
+        if (stack.isEmpty()) it = undo_.erase(it);
+        else { it.value() = stack; ++it; }
+    }
+    dead_ = 0;
+    prefix_ = 0;
+    invalidate();
+}
+
+int AnnotModel::finishedPrefix() const
+{
+    while (prefix_ < order_.size()) {
+        const Stroke& s = store_[order_[prefix_]];
+        if (s.alive && !s.finished) break;
+        ++prefix_;
+    }
+    return prefix_;
+}
+
+int AnnotModel::padPx(const Stroke& s)
+{
+    switch (s.tool) {
+    case Arrow: return qMax(8, s.width * 3) + s.width + 2;
+    case Text:  return 0;
+    default:    return s.width + 2;
+    }
+}
+
+QRect AnnotModel::pixelRect(const QRectF& n, int pad, const QSize& size)
+{
+    const QRectF r(denorm(n.topLeft(), size), denorm(n.bottomRight(), size));
+    return r.toAlignedRect().adjusted(-pad, -pad, pad, pad) & QRect(QPoint(0, 0), size);
+}
+
 void AnnotModel::paint(QPainter& p, const QSize& size) const
 {
     p.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform, true);
-    for (const QString& id : order_) {
-        const auto it = strokes_.find(id);
-        if (it == strokes_.end()) continue;
-        const Stroke& s = it.value();
-
-        QPen pen(s.color, s.width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
-        p.setPen(pen);
-        p.setBrush(Qt::NoBrush);
-        auto D = [&](int i){ return denorm(s.pts[i], size); };
-
-        switch (s.tool) {
-        case Rect:
-            if (s.pts.size() >= 2) {
-                QRectF r; r.setTopLeft(D(0)); r.setBottomRight(D(s.pts.size()-1)); r = r.normalized();
-                p.drawRect(r);
-            }
-            break;
-        case Ellipse:
-            if (s.pts.size() >= 2) {
-                QRectF r; r.setTopLeft(D(0)); r.setBottomRight(D(s.pts.size()-1)); r = r.normalized();
-                p.drawEllipse(r);
-            }
-            break;
-        case Arrow:
-            if (s.pts.size() >= 2) {
-                drawArrow(p, D(0), D(s.pts.size()-1), s.width, s.color);
-            }
-            break;
-        case Pen:
-            if (s.pts.size() >= 2) {
-                QPainterPath path(D(0));
-                for (int i=1;i<s.pts.size();++i) path.lineTo(D(i));
-                p.drawPath(path);
+    if (size.width() < 1 || size.height() < 1) return;
+
+    const int baked = finishedPrefix();
+    if (baked > 0) {
+        const quint64 key = (quint64(size.width()) << 32) | quint64(size.height());
+        if (!layers_.contains(key) && layers_.size() >= kMaxLayers) layers_.clear();
+        Layer& L = layers_[key];
+        if (L.img.isNull() || L.rev != rev_ || L.baked > baked) {
+            L.img = QImage(size, QImage::Format_ARGB32_Premultiplied);
+            L.img.fill(Qt::transparent);
+            L.baked = 0;
+            L.erased = erased_.size();
+            L.rev = rev_;
+        }
+        if (L.erased < erased_.size() || L.baked < baked) {
+            QPainter lp(&L.img);
+            lp.setRenderHints(p.renderHints());
+            lp.setFont(p.font());
+
+            // 撤销/改动过的区域：清掉后只重画与之相交、且已在缓存里的笔画
+            const double padN = double(maxPad_) / qMin(size.width(), size.height());
+            for (; L.erased < erased_.size(); ++L.erased) {
+                const QRect r = pixelRect(erased_[L.erased].first, erased_[L.erased].second, size);
+                if (r.isEmpty()) continue;
+                lp.save();
+                lp.setCompositionMode(QPainter::CompositionMode_Clear);
+                lp.fillRect(r, Qt::transparent);
+                lp.restore();
+                lp.save();
+                lp.setClipRect(r);
+                const QRectF n(double(r.left()) / size.width() - padN, double(r.top()) / size.height() - padN,
+                               double(r.width()) / size.width() + 2 * padN, double(r.height()) / size.height() + 2 * padN);
+                for (int h : query(n))
+                    if (store_[h].pos < L.baked) paintStroke(lp, store_[h], size);
+                lp.restore();
             }
-            break;
-        case Text:
-            if (!s.pts.isEmpty()) {
-                QFont f = p.font();
-                f.setPointSizeF(qMax(12.0, size.height() * 0.035));
-                p.setFont(f);
-                p.setPen(QPen(s.color, 1));
-                p.drawText(D(0), s.text);
+
+            for (int i = L.baked; i < baked; ++i) {
+                const Stroke& s = store_[order_[i]];
+                if (s.alive) paintStroke(lp, s, size);
             }
-            break;
+            L.baked = baked;
+        }
+        p.drawImage(QPointF(0, 0), L.img);
+    }
+
+    for (int i = baked; i < order_.size(); ++i) {
+        const Stroke& s = store_[order_[i]];
+        if (s.alive) paintStroke(p, s, size);
+    }
+}
+
+void AnnotModel::paintStroke(QPainter& p, const Stroke& s, const QSize& size)
+{
+    QPen pen(s.color, s.width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+    p.setPen(pen);
+    p.setBrush(Qt::NoBrush);
+
+    auto D = [&](int i){ return denorm(s.pts[i], size); };
+
+    switch (s.tool) {
+    case Rect:
+        if (s.pts.size() >= 2) {
+            QRectF r;
+            r.setTopLeft(D(0));
+            r.setBottomRight(D(s.pts.size()-1));
+            r = r.normalized();
+            p.drawRect(r);
+        }
+        break;
+    case Ellipse:
+        if (s.pts.size() >= 2) {
+            QRectF r;
+            r.setTopLeft(D(0));
+            r.setBottomRight(D(s.pts.size()-1));
+            r = r.normalized();
+            p.drawEllipse(r);
+        }
+        break;
+    case Arrow:
+        if (s.pts.size() >= 2) {
+            drawArrow(p, D(0), D(s.pts.size()-1), s.width, s.color);
+        }
+        break;
+    case Pen:
+        if (s.pts.size() >= 2) {
+            QPainterPath path(D(0));
+            for (int i=1;i<s.pts.size();++i) path.lineTo(D(i));
+            p.drawPath(path);
+        }
+        break;
+    case Text:
+        if (!s.pts.isEmpty()) {
+            QFont f = p.font();
+            f.setPointSizeF(qMax(12.0, size.height() * 0.035));
+            p.setFont(f);
+            p.setPen(QPen(s.color, 1));
+            p.drawText(D(0), s.text);
         }
+        break;
     }
 }
 
 void AnnotModel::clear()
 {
-    strokes_.clear();
+    store_.clear();
     order_.clear();
+    byId_.clear();
+    undo_.clear();
+    for (auto& c : cells_) c.clear();
+    live_ = dead_ = maxPad_ = 0;
+    prefix_ = 0;
+    layers_.clear();
+    touch(QRectF(0, 0, 1, 1));
+    invalidate();
 }
@@ -0,0 +1,163 @@
+#include "audiodsp.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define AUDIODSP_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define AUDIODSP_NEON 1
+#endif
+
+namespace AudioDsp {
+
+static inline qint16 sat16(qint32 v) {
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return qint16(v);
+}
+
+void mixAccumulate(qint32* acc, const qint16* in, int n, qint32 gainQ12)
+{
+    if (gainQ12 <= 0) return;
+    int i = 0;
+#if defined(AUDIODSP_SSE2)
+    if (gainQ12 == kGainOne) {
+        // 单位增益：符号扩展后直接累加
+        for (; i + 8 <= n; i += 8) {
+            const __m128i x  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+            const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+            __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+            _mm_storeu_si128(a,     _mm_add_epi32(_mm_loadu_si128(a),     lo));
+            _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), hi));
+        }
+    } else {
+        // 16x16->32 乘法：mullo/mulhi 拼出完整乘积再右移 12
+        const __m128i g = _mm_set1_epi16(qint16(gainQ12));
+        for (; i + 8 <= n; i += 8) {
+            const __m128i x   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            const __m128i pl  = _mm_mullo_epi16(x, g);
+            const __m128i ph  = _mm_mulhi_epi16(x, g);
+            const __m128i lo  = _mm_srai_epi32(_mm_unpacklo_epi16(pl, ph), 12);
+            const __m128i hi  = _mm_srai_epi32(_mm_unpackhi_epi16(pl, ph), 12);
+            __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+            _mm_storeu_si128(a,     _mm_add_epi32(_mm_loadu_si128(a),     lo));
+            _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), hi));
+        }
+    }
+#elif defined(AUDIODSP_NEON)
+    const int16x4_t g = vdup_n_s16(qint16(gainQ12));
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t x = vld1q_s16(in + i);
+        const int32x4_t lo = vshrq_n_s32(vmull_s16(vget_low_s16(x),  g), 12);
+        const int32x4_t hi = vshrq_n_s32(vmull_s16(vget_high_s16(x), g), 12);
+        vst1q_s32(acc + i,     vaddq_s32(vld1q_s32(acc + i),     lo));
+        vst1q_s32(acc + i + 4, vaddq_s32(vld1q_s32(acc + i + 4), hi));
+    }
+#endif
+    for (; i < n; ++i) acc[i] += (qint32(in[i]) * gainQ12) >> 12;
+}
+
+void packSaturate(qint16* out, const qint32* acc, int n)
+{
+    int i = 0;
+#if defined(AUDIODSP_SSE2)
+    for (; i + 8 <= n; i += 8) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+    }
+#elif defined(AUDIODSP_NEON)
+    for (; i + 8 <= n; i += 8) {
+        const int16x4_t a = vqmovn_s32(vld1q_s32(acc + i));
+        const int16x4_t b = vqmovn_s32(vld1q_s32(acc + i + 4));
+        vst1q_s16(out + i, vcombine_s16(a, b));
+    }
+#endif
+    for (; i < n; ++i) out[i] = sat16(acc[i]);
+}
+
+void applyGain(qint16* pcm, int n, qint32 gainQ12)
+{
+    if (gainQ12 == kGainOne) return;
+    int i = 0;
+#if defined(AUDIODSP_SSE2)
+    const __m128i g = _mm_set1_epi16(qint16(gainQ12));
+    for (; i + 8 <= n; i += 8) {
+        __m128i* p = reinterpret_cast<__m128i*>(pcm + i);
+        const __m128i x  = _mm_loadu_si128(p);
+        const __m128i pl = _mm_mullo_epi16(x, g);
+        const __m128i ph = _mm_mulhi_epi16(x, g);
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(pl, ph), 12);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(pl, ph), 12);
+        _mm_storeu_si128(p, _mm_packs_epi32(lo, hi));
+    }
+#elif defined(AUDIODSP_NEON)
+    const int16x4_t g = vdup_n_s16(qint16(gainQ12));
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t x = vld1q_s16(pcm + i);
+        const int16x4_t lo = vqmovn_s32(vshrq_n_s32(vmull_s16(vget_low_s16(x),  g), 12));
+        const int16x4_t hi = vqmovn_s32(vshrq_n_s32(vmull_s16(vget_high_s16(x), g), 12));
+        vst1q_s16(pcm + i, vcombine_s16(lo, hi));
+    }
+#endif
+    for (; i < n; ++i) pcm[i] = sat16((qint32(pcm[i]) * gainQ12) >> 12);
+}
+
+int frameRms(const qint16* pcm, int n)
+{
+    if (n <= 0) return 0;
+    qint64 acc = 0;
+    for (int i = 0; i < n; ++i) acc += qint32(pcm[i]) * pcm[i];
+    return int(std::sqrt(double(acc) / n));
+}
+
+void VoiceDetector::reset()
+{
+    floor_ = 0.0f;
+    primed_ = false;
+    hang_ = 0;
+}
+
+bool VoiceDetector::process(const qint16* pcm, int n)
+{
+    if (n <= 0) return hang_ > 0;
+    const float rms = float(frameRms(pcm, n));
+
+    int zc = 0;
+    for (int i = 1; i < n; ++i) zc += ((pcm[i - 1] ^ pcm[i]) < 0);
+    const float zcr = float(zc) / n;
+
+    if (!primed_) { floor_ = rms; primed_ = true; }
+
+    const float thr = qMax(float(kMinSpeech), floor_ * kOnRatio);
+    bool voice = rms > thr;
+    // 清音（擦音/爆破音）能量低但过零率高，单独放宽门限
+    if (!voice && zcr > 0.3f && rms > qMax(float(kMinSpeech), floor_ * kZcrRatio)) voice = true;
+
+    // 噪声底：向下快跟、向上慢爬，说话期间基本不动
+    if (rms < floor_)  floor_ += (rms - floor_) * 0.125f;
+    else if (!voice)   floor_ += (rms - floor_) * 0.02f;
+    else               floor_ += (rms - floor_) * 0.0005f;
+    floor_ = qMax(floor_, 1.0f);
+
+    if (voice) hang_ = kHangFrames;
+    else if (hang_ > 0) --hang_;
+    return voice || hang_ > 0;
+}
+
+void ComfortNoise::generate(qint16* out, int n, int levelRms)
+{
+    level_ += (float(qBound(0, levelRms, 4000)) - level_) * 0.25f;
+    // 均匀白噪声 RMS = 幅度/√3；一阶低通(0.5)后功率降为 1/3，这里一并补偿
+    const float amp = level_ * 3.0f;
+    for (int i = 0; i < n; ++i) {
+        seed_ = seed_ * 1664525u + 1013904223u;
+        const float w = (float(qint32(seed_) >> 8) / 8388608.0f) * amp;
+        lp_ += (w - lp_) * 0.5f;
+        out[i] = sat16(qint32(lp_));
+    }
+}
+
+} // namespace AudioDsp
@@ -0,0 +1,58 @@
+#pragma once
+#include <QtCore>
+
+// 音频混音内核（SSE2 / NEON / 标量三套实现，编译期选择）
+// 增益统一用 Q12 定点：4096 = 1.0，取值 0..16384（最大 4.0）
+namespace AudioDsp {
+
+constexpr int kGainOne = 4096;
+
+inline qint32 gainToQ12(float g) { return qBound(0, int(g * kGainOne + 0.5f), 4 * kGainOne); }
+
+// acc[i] += (in[i] * gainQ12) >> 12
+void mixAccumulate(qint32* acc, const qint16* in, int n, qint32 gainQ12);
+
+// out[i] = saturate16(acc[i])
+void packSaturate(qint16* out, const qint32* acc, int n);
+
+// pcm[i] = saturate16((pcm[i] * gainQ12) >> 12)，原地
+void applyGain(qint16* pcm, int n, qint32 gainQ12);
+
+// 帧均方根幅度
+int frameRms(const qint16* pcm, int n);
+
+// 发送端语音检测：短时能量 + 过零率，噪声底自适应，带拖尾
+class VoiceDetector {
+public:
+    void reset();
+
+    // 输入一帧，返回本帧是否需要发送（语音或拖尾期内）
+    bool process(const qint16* pcm, int n);
+
+    int  noiseLevel() const { return int(floor_); }   // 当前噪声底（RMS）
+    bool inSpeech() const { return hang_ > 0; }
+
+private:
+    static constexpr int   kHangFrames = 10;     // 200ms@20ms 拖尾，防止句尾被截断
+    static constexpr int   kMinSpeech  = 180;    // 低于此 RMS 一律视为静音
+    static constexpr float kOnRatio    = 3.0f;   // 高于噪声底约 9.5dB 判为语音
+    static constexpr float kZcrRatio   = 2.0f;   // 清音（高过零率）放宽到约 6dB
+
+    float floor_  = 0.0f;
+    bool  primed_ = false;
+    int   hang_   = 0;
+};
+
+// 接收端舒适噪声：按对端上报的噪声底 RMS 生成轻度低通的白噪声
+class ComfortNoise {
+public:
+    void generate(qint16* out, int n, int levelRms);
+    void reset() { lp_ = 0.0f; level_ = 0.0f; }
+
+private:
+    quint32 seed_  = 0x1234567u;
+    float   lp_    = 0.0f;
+    float   level_ = 0.0f;   // 平滑后的电平，避免段与段之间跳变
+};
+
+} // namespace AudioDsp
@@ -30,6 +30,7 @@ enum MsgType : quint16 {
 };
 
 // 额外定义一个标注消息类型（按你项目现有约定）
+// bin: 点坐标，每点 u16 x, u16 y（BigEndian，归一化坐标乘 65535），见 AnnotModel::packPoints
 static const quint16 MSG_ANNOT = 1206;
 
 // 安全上限（防御异常/恶意输入）
@@ -14,16 +14,30 @@ SOURCES += \
     src/udprelay.cpp \
     src/udpmedia_client.cpp \
     src/recorder.cpp \
+    src/audiomixer.cpp \
+    src/activespeaker.cpp \
+    src/roomstate.cpp \
+    src/dbpool.cpp \
     common/protocol.cpp \
-    common/annot.cpp
+    common/annot.cpp \
+    common/audiodsp.cpp \
+    common/audiocodec.cpp \
+    common/videocodec.cpp
 
 HEADERS += \
     src/roomhub.h \
     src/udprelay.h \
     src/udpmedia_client.h \
     src/recorder.h \
+    src/audiomixer.h \
+    src/activespeaker.h \
+    src/roomstate.h \
+    src/dbpool.h \
     common/protocol.h \
-    common/annot.h
+    common/annot.h \
+    common/audiodsp.h \
+    common/audiocodec.h \
+    common/videocodec.h
 
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,67 @@
+#include "activespeaker.h"
+#include <algorithm>
+
+void ActiveSpeakerTracker::onAudio(const QString& sender, int level, qint64 nowMs)
+{
+    Window& w = senders_[sender];
+    const qint64 bin = nowMs / kBinMs;
+    const int i = int(bin % kBins);
+    if (w.stamp[i] != bin) { w.stamp[i] = bin; w.sum[i] = 0; }
+    w.sum[i] += qMax(0, level);
+    w.lastMs = nowMs;
+}
+
+void ActiveSpeakerTracker::remove(const QString& sender)
+{
+    senders_.remove(sender);
+    scores_.remove(sender);
+    ranking_.removeAll(sender);
+    recent_.removeAll(sender);
+    if (active_ == sender) active_.clear();
+}
+
+int ActiveSpeakerTracker::score(const Window& w, qint64 nowMs) const
+{
+    const qint64 cur = nowMs / kBinMs;
+    qint64 total = 0;
+    for (int i = 0; i < kBins; ++i) {
+        if (cur - w.stamp[i] < kBins) total += w.sum[i];
+    }
+    return int(total / kFramesPerWindow);
+}
+
+bool ActiveSpeakerTracker::update(qint64 nowMs)
+{
+    QVector<QPair<int, QString>> ranked;
+    ranked.reserve(senders_.size());
+    scores_.clear();
+    for (auto it = senders_.constBegin(); it != senders_.constEnd(); ++it) {
+        const int s = score(it.value(), nowMs);
+        scores_.insert(it.key(), s);
+        if (s >= kMinScore) ranked.append(qMakePair(s, it.key()));
+    }
+    std::sort(ranked.begin(), ranked.end(),
+              [](const QPair<int, QString>& a, const QPair<int, QString>& b) { return a.first > b.first; });
+
+    ranking_.clear();
+    for (const auto& r : ranked) ranking_ << r.second;
+
+    // 按名次从低到高依次挪到最前，排名第一的最终在队首
+    for (int i = ranking_.size() - 1; i >= 0; --i) {
+        recent_.removeAll(ranking_.at(i));
+        recent_.prepend(ranking_.at(i));
+    }
+
+    const QString top = ranking_.value(0);
+    if (top.isEmpty() || top == active_) return false;
+
+    // 当前主讲人还在说：只有保持够久且新人明显更响才切换
+    const int cur = scores_.value(active_);
+    if (!active_.isEmpty() && cur >= kMinScore) {
+        if (nowMs - activeSince_ < kHoldMs) return false;
+        if (scores_.value(top) < cur * kSwitchRatio) return false;
+    }
+    active_ = top;
+    activeSince_ = nowMs;
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <QtCore>
+
+// 单个房间的说话人排名
+// 每路语音按 100ms 分桶累计帧电平，取最近 1s 的平均（静音/DTX 期间没有包，自然记为 0）
+// 主讲人切换要求新人明显更响且上一位已保持至少 kHoldMs，避免在两人之间来回跳
+class ActiveSpeakerTracker {
+public:
+    void onAudio(const QString& sender, int level, qint64 nowMs);
+    void remove(const QString& sender);
+
+    // 重新计算排名；主讲人发生变化时返回 true
+    bool update(qint64 nowMs);
+
+    QString active() const { return active_; }
+    const QStringList& ranking() const { return ranking_; }
+    const QStringList& recent() const { return recent_; }   // 最近发过言的人，越靠前越近
+    int  rankOf(const QString& sender) const { return ranking_.indexOf(sender); }
+    int  scoreOf(const QString& sender) const { return scores_.value(sender); }
+    bool isEmpty() const { return senders_.isEmpty(); }
+
+private:
+    static constexpr int    kBinMs    = 100;
+    static constexpr int    kBins     = 10;     // 1s 窗口
+    static constexpr int    kFramesPerWindow = 50;
+    static constexpr int    kMinScore = 150;    // 窗口平均幅度低于此值不参与排名
+    static constexpr int    kHoldMs   = 1000;
+    static constexpr double kSwitchRatio = 1.5;
+
+    struct Window {
+        qint64 stamp[kBins] = {};   // 桶对应的 100ms 序号
+        qint64 sum[kBins]   = {};
+        qint64 lastMs = 0;
+    };
+
+    int score(const Window& w, qint64 nowMs) const;
+
+    QHash<QString, Window> senders_;
+    QHash<QString, int>    scores_;
+    QStringList ranking_;
+    QStringList recent_;
+    QString     active_;
+    qint64      activeSince_ = 0;
+};
@@ -0,0 +1,219 @@
+#include "audiomixer.h"
+#include <algorithm>
+
+const QString AudioMixer::kMixSender = QStringLiteral("__mix__");
+
+AudioMixer::AudioMixer(QObject* parent) : QObject(parent)
+{
+    qRegisterMetaType<AudioMixBatch>("AudioMixBatch");
+}
+
+AudioMixer::~AudioMixer()
+{
+    for (Room* room : qAsConst(rooms_)) qDeleteAll(room->speakers);
+    qDeleteAll(rooms_);
+}
+
+void AudioMixer::start()
+{
+    // 定时器必须在混音线程里创建
+    timer_ = new QTimer(this);
+    timer_->setTimerType(Qt::PreciseTimer);
+    timer_->setInterval(kFrameMs);
+    connect(timer_, &QTimer::timeout, this, &AudioMixer::onTick);
+    clock_.start();
+    produced_ = 0;
+    timer_->start();
+}
+
+void AudioMixer::setRoom(const QString& roomId, const QStringList& members, const QStringList& wbMembers)
+{
+    Room*& room = rooms_[roomId];
+    if (!room) room = new Room;
+
+    const QSet<QString> keep = QSet<QString>::fromList(members);
+    for (auto it = room->receivers.begin(); it != room->receivers.end(); ) {
+        if (!keep.contains(it.key())) it = room->receivers.erase(it);
+        else ++it;
+    }
+    for (auto it = room->speakers.begin(); it != room->speakers.end(); ) {
+        if (!keep.contains(it.key())) { delete it.value(); it = room->speakers.erase(it); }
+        else ++it;
+    }
+    for (const QString& m : members) room->receivers[m].wb = wbMembers.contains(m);
+}
+
+void AudioMixer::removeRoom(const QString& roomId)
+{
+    Room* room = rooms_.take(roomId);
+    if (!room) return;
+    qDeleteAll(room->speakers);
+    delete room;
+}
+
+void AudioMixer::pushFrame(const QString& roomId, const QString& sender, const QString& codec,
+                           int sr, const QByteArray& payload)
+{
+    Room* room = rooms_.value(roomId);
+    if (!room || !room->receivers.contains(sender)) return;
+    if (codec == "cn") return;   // 静音标记：该路队列自然放空即可
+
+    Speaker*& sp = room->speakers[sender];
+    if (!sp) sp = new Speaker;
+
+    if (sp->count >= kMaxLagFrames) {   // 积压：丢最旧帧
+        sp->head = (sp->head + 1) % kQueueFrames;
+        --sp->count;
+    }
+    qint16* out = sp->frames[(sp->head + sp->count) % kQueueFrames];
+
+    int n = 0;
+    if (codec == "adpcm16") {
+        n = sp->dec.decodeAdpcm(reinterpret_cast<const quint8*>(payload.constData()), payload.size(),
+                                out, kFrameSamples);
+    } else if (codec == "mulaw" || codec == "pcm16") {
+        qint16 nb[kFrameSamples];
+        int m = 0;
+        if (codec == "mulaw") {
+            m = qMin(payload.size(), int(kFrameSamples));
+            const uchar* u = reinterpret_cast<const uchar*>(payload.constData());
+            for (int i = 0; i < m; ++i) nb[i] = AudioCodec::ulawToLinear(u[i]);
+        } else {
+            m = qMin(payload.size() / 2, int(kFrameSamples));
+            memcpy(nb, payload.constData(), size_t(m) * 2);
+        }
+        if (sr == kSampleRate) { n = m; memcpy(out, nb, size_t(m) * 2); }
+        else                   n = sp->dec.fromNarrow(nb, m, out, kFrameSamples);
+    }
+    if (n <= 0) return;
+    if (n < kFrameSamples) memset(out + n, 0, size_t(kFrameSamples - n) * 2);
+    ++sp->count;
+}
+
+void AudioMixer::onTick()
+{
+    // 按单调时钟补齐应产出的帧，定时器偶尔迟到也不会累积漂移
+    const qint64 due = clock_.elapsed() / kFrameMs;
+    int budget = 3;
+    while (produced_ < due && budget-- > 0) {
+        for (auto it = rooms_.begin(); it != rooms_.end(); ++it) mixRoom(it.key(), *it.value());
+        ++produced_;
+    }
+    if (produced_ < due) produced_ = due;  // 落后太多：直接跳过，不追帧
+}
+
+void AudioMixer::mixRoom(const QString& roomId, Room& room)
+{
+    // 1) 每路取一帧，按能量挑出前 K 名
+    struct Pick { const QString* who; const qint16* pcm; int rms; };
+    Pick picks[64];
+    int np = 0;
+    for (auto it = room.speakers.begin(); it != room.speakers.end(); ++it) {
+        Speaker* sp = it.value();
+        if (!sp->primed) {
+            if (sp->count < kPrimeFrames) continue;
+            sp->primed = true;
+        }
+        if (sp->count == 0) { sp->primed = false; continue; }
+        const qint16* pcm = sp->frames[sp->head];
+        sp->head = (sp->head + 1) % kQueueFrames;
+        --sp->count;
+        if (np < 64) picks[np++] = Pick{ &it.key(), pcm, AudioDsp::frameRms(pcm, kFrameSamples) };
+    }
+
+    const qint64 ts = QDateTime::currentMSecsSinceEpoch();
+    AudioMixBatch out;
+
+    if (np == 0) {
+        // 全员静音：给上一拍还在收语音的人发一次静音标记，然后停发
+        if (!room.active) return;
+        room.active = false;
+        const QByteArray cn = silenceMarker(roomId, ts);
+        for (auto it = room.receivers.begin(); it != room.receivers.end(); ++it) {
+            if (it->talking) { out.insert(it.key(), cn); it->talking = false; }
+        }
+        if (!out.isEmpty()) emit mixReady(roomId, out);
+        return;
+    }
+    room.active = true;
+
+    const int k = qMin(np, int(kTopK));
+    std::partial_sort(picks, picks + k, picks + np,
+                      [](const Pick& a, const Pick& b) { return a.rms > b.rms; });
+
+    // 2) 前 K 名混成公共流
+    memset(acc_, 0, sizeof(acc_));
+    for (int i = 0; i < k; ++i) AudioDsp::mixAccumulate(acc_, picks[i].pcm, kFrameSamples, AudioDsp::kGainOne);
+    AudioDsp::packSaturate(common_, acc_, kFrameSamples);
+
+    // 3) 公共流按编码各编一次；前 K 名说话人各自去掉本人声音后单独编码
+    //    包头（seq / 段首标记）按接收端各自生成，负载共享
+    QByteArray commonWb, commonNb;
+    for (auto it = room.receivers.begin(); it != room.receivers.end(); ++it) {
+        Receiver& r = it.value();
+        const Pick* self = nullptr;
+        for (int i = 0; i < k; ++i) if (*picks[i].who == it.key()) { self = &picks[i]; break; }
+
+        if (self) {
+            if (k == 1) {   // 只有本人在说：对他而言是静音
+                if (r.talking) { out.insert(it.key(), silenceMarker(roomId, ts)); r.talking = false; }
+                continue;
+            }
+            for (int i = 0; i < kFrameSamples; ++i) minus_[i] = acc_[i] - self->pcm[i];
+            AudioDsp::packSaturate(own_, minus_, kFrameSamples);
+            out.insert(it.key(), framePacket(r, roomId, ts, encode(r.wb, r.enc, own_)));
+        } else if (r.wb) {
+            if (commonWb.isEmpty()) commonWb = encode(true, room.commonWb, common_);
+            out.insert(it.key(), framePacket(r, roomId, ts, commonWb));
+        } else {
+            if (commonNb.isEmpty()) commonNb = encode(false, room.commonNb, common_);
+            out.insert(it.key(), framePacket(r, roomId, ts, commonNb));
+        }
+    }
+    if (!out.isEmpty()) emit mixReady(roomId, out);
+}
+
+QByteArray AudioMixer::encode(bool wb, AudioCodec::WidebandEncoder& enc, const qint16* pcm)
+{
+    QByteArray payload;
+    if (wb) {
+        payload.resize(AudioCodec::adpcmWbBytes(kFrameSamples));
+        payload.resize(enc.encodeAdpcm(pcm, kFrameSamples, reinterpret_cast<quint8*>(payload.data())));
+    } else {
+        qint16 nb[kFrameSamples / 2];
+        const int n = enc.toNarrow(pcm, kFrameSamples, nb);
+        payload.resize(n);
+        for (int i = 0; i < n; ++i) payload[i] = static_cast<char>(AudioCodec::linearToUlaw(nb[i]));
+    }
+    return payload;
+}
+
+QByteArray AudioMixer::framePacket(Receiver& r, const QString& roomId, qint64 ts, const QByteArray& payload)
+{
+    QJsonObject j{
+        {"roomId", roomId},
+        {"sender", kMixSender},
+        {"codec",  r.wb ? "adpcm16" : "mulaw"},
+        {"sr",     r.wb ? int(kSampleRate) : kSampleRate / 2},
+        {"ch",     1},
+        {"seq",    static_cast<int>(r.seq++)},
+        {"ts",     ts}
+    };
+    if (!r.talking) j["m"] = 1;
+    r.talking = true;
+    return buildPacket(MSG_AUDIO_FRAME, j, payload);
+}
+
+QByteArray AudioMixer::silenceMarker(const QString& roomId, qint64 ts) const
+{
+    QJsonObject j{
+        {"roomId", roomId},
+        {"sender", kMixSender},
+        {"codec",  "cn"},
+        {"sr",     kSampleRate},
+        {"ch",     1},
+        {"level",  0},
+        {"ts",     ts}
+    };
+    return buildPacket(MSG_AUDIO_FRAME, j);
+}
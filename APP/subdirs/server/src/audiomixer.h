@@ -0,0 +1,86 @@
+#pragma once
+#include <QtCore>
+#include "protocol.h"
+#include "audiodsp.h"
+#include "audiocodec.h"
+
+// receiver -> 已组好的 MSG_AUDIO_FRAME 包（QHash 已自动声明元类型，这里只需注册别名）
+using AudioMixBatch = QHash<QString, QByteArray>;
+
+// 服务端混音（MCU 模式）：大房间里不再逐路转发语音，
+// 每 20ms 取最响的 K 路混成一路，按接收端去掉其本人声音（mix-minus）后重新编码下发
+// 运行在独立线程，所有槽都通过排队连接调用；结果以 mixReady 信号交回 RoomHub 写 socket
+class AudioMixer : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kFrameMs      = 20;
+    static constexpr int kSampleRate   = 16000;
+    static constexpr int kFrameSamples = kSampleRate * kFrameMs / 1000;
+    static constexpr int kTopK         = 3;     // 同时混入的说话人上限，控制 CPU
+    static const QString kMixSender;            // 下发混音流使用的 sender
+
+    explicit AudioMixer(QObject* parent = nullptr);
+    ~AudioMixer() override;
+
+public slots:
+    void start();
+
+    // 房间进入/离开 MCU 模式，或成员/能力变化
+    void setRoom(const QString& roomId, const QStringList& members, const QStringList& wbMembers);
+    void removeRoom(const QString& roomId);
+
+    // 一帧上行语音（原始负载，在混音线程里解码）
+    void pushFrame(const QString& roomId, const QString& sender, const QString& codec,
+                   int sr, const QByteArray& payload);
+
+signals:
+    void mixReady(const QString& roomId, const AudioMixBatch& packets);
+
+private slots:
+    void onTick();
+
+private:
+    static constexpr int kQueueFrames = 8;   // 每路上行缓冲帧数
+    static constexpr int kPrimeFrames = 2;   // 攒够 2 帧再开始消费，吸收网络抖动
+    static constexpr int kMaxLagFrames = 6;  // 积压超过则丢最旧帧，限制时延
+
+    // TCP 传输不会乱序/丢包，上行只需一个定长 FIFO 吸收抖动
+    struct Speaker {
+        qint16 frames[kQueueFrames][kFrameSamples];
+        int    head = 0;
+        int    count = 0;
+        bool   primed = false;
+        AudioCodec::WidebandDecoder dec;
+    };
+
+    struct Receiver {
+        bool    wb = false;
+        quint32 seq = 0;
+        bool    talking = false;     // 上一拍是否下发过语音
+        AudioCodec::WidebandEncoder enc;   // 处于前 K 名时使用自己的 mix-minus 编码器
+    };
+
+    struct Room {
+        QHash<QString, Speaker*>  speakers;
+        QHash<QString, Receiver>  receivers;
+        AudioCodec::WidebandEncoder commonWb;   // 非说话人共享同一路混音，只编一次
+        AudioCodec::WidebandEncoder commonNb;
+        bool active = false;
+    };
+
+    void mixRoom(const QString& roomId, Room& room);
+    static QByteArray encode(bool wb, AudioCodec::WidebandEncoder& enc, const qint16* pcm);
+    static QByteArray framePacket(Receiver& r, const QString& roomId, qint64 ts, const QByteArray& payload);
+    QByteArray silenceMarker(const QString& roomId, qint64 ts) const;
+
+    QHash<QString, Room*> rooms_;
+    QTimer*       timer_ = nullptr;
+    QElapsedTimer clock_;
+    qint64        produced_ = 0;     // 已产出的帧数（对齐到 20ms 时钟）
+
+    // 预分配的混音缓冲
+    qint32 acc_[kFrameSamples];
+    qint32 minus_[kFrameSamples];
+    qint16 common_[kFrameSamples];
+    qint16 own_[kFrameSamples];
+};
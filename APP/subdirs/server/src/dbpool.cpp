@@ -0,0 +1,117 @@
+#include "dbpool.h"
+
+struct DbPool::ThreadConn {
+    QString name;
+    QHash<QString, QSqlQuery> stmts;   // SQL 文本 -> 预编译语句
+    ~ThreadConn() {
+        if (tConn_ == this) tConn_ = nullptr;
+        stmts.clear();   // 语句须先于连接释放
+        { QSqlDatabase db = QSqlDatabase::database(name, false); db.close(); }
+        QSqlDatabase::removeDatabase(name);
+    }
+    void finishAll() {
+        for (auto it = stmts.begin(); it != stmts.end(); ++it)
+            if (it->isActive()) it->finish();
+    }
+};
+
+thread_local DbPool::ThreadConn* DbPool::tConn_ = nullptr;
+
+class DbPool::Task : public QRunnable {
+public:
+    Task(DbPool* pool, quint64 id, Job job, const QString& label)
+        : pool_(pool), id_(id), job_(std::move(job)), label_(label) {}
+    void run() override {
+        QElapsedTimer t; t.start();
+        QSqlDatabase db = pool_->threadConnection();
+        QJsonObject rep;
+        if (!db.isOpen()) rep = QJsonObject{{"ok", false}, {"msg", QStringLiteral("数据库错误")}};
+        else rep = job_(db);
+        if (tConn_) tConn_->finishAll();
+        const qint64 ms = t.elapsed();
+        if (ms >= kSlowMs) qWarning().noquote() << "[db] slow job" << label_ << ms << "ms";
+        pool_->inFlight_.fetchAndSubAcquire(1);
+        emit pool_->jobFinished(id_, rep);
+    }
+private:
+    DbPool* pool_;
+    quint64 id_;
+    Job job_;
+    QString label_;
+};
+
+DbPool::DbPool(const QString& dbFile, int threads, int maxQueued, QObject* parent)
+    : QObject(parent), dbFile_(dbFile), maxQueued_(qMax(1, maxQueued))
+{
+    pool_.setMaxThreadCount(qMax(1, threads));
+    pool_.setExpiryTimeout(-1);   // 线程常驻，连接随线程复用
+    connect(this, &DbPool::jobFinished, this, &DbPool::onJobFinished, Qt::QueuedConnection);
+}
+
+DbPool::~DbPool()
+{
+    pool_.waitForDone();
+}
+
+bool DbPool::submit(Job job, QObject* ctx, Done done, const QString& label)
+{
+    if (inFlight_.fetchAndAddAcquire(1) >= maxQueued_) {
+        inFlight_.fetchAndSubAcquire(1);
+        return false;
+    }
+    const quint64 id = nextId_++;
+    Waiter w;
+    w.ctx = ctx;
+    w.hasCtx = (ctx != nullptr);
+    w.done = std::move(done);
+    waiters_.insert(id, std::move(w));
+    pool_.start(new Task(this, id, std::move(job), label));
+    return true;
+}
+
+void DbPool::onJobFinished(quint64 id, QJsonObject result)
+{
+    const Waiter w = waiters_.take(id);
+    if (w.done && (!w.hasCtx || w.ctx)) w.done(result);
+}
+
+QSqlDatabase DbPool::threadConnection()
+{
+    if (!conns_.hasLocalData()) {
+        auto* c = new ThreadConn;
+        c->name = QString("db-worker-%1").arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+        conns_.setLocalData(c);
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", c->name);
+        db.setDatabaseName(dbFile_);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");   // 多条连接写同一文件时等锁而不是立刻失败
+        if (!db.open()) qWarning() << "[db] open failed:" << db.lastError().text();
+        else tune(db);
+    }
+    tConn_ = conns_.localData();
+    return QSqlDatabase::database(tConn_->name, false);
+}
+
+void DbPool::tune(QSqlDatabase& db)
+{
+    QSqlQuery q(db);
+    q.exec("PRAGMA synchronous=NORMAL");
+    q.exec("PRAGMA cache_size=-8192");     // 8 MiB
+    q.exec("PRAGMA temp_store=MEMORY");
+}
+
+QSqlQuery DbPool::prepared(QSqlDatabase& db, const QString& sql)
+{
+    if (tConn_ && tConn_->name == db.connectionName()) {
+        auto it = tConn_->stmts.find(sql);
+        if (it != tConn_->stmts.end()) {
+            if (it->isActive()) it->finish();
+            return it.value();
+        }
+        QSqlQuery q(db);
+        if (q.prepare(sql)) tConn_->stmts.insert(sql, q);
+        return q;
+    }
+    QSqlQuery q(db);
+    q.prepare(sql);
+    return q;
+}
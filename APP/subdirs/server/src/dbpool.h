@@ -0,0 +1,58 @@
+#pragma once
+#include <QtCore>
+#include <QtSql>
+#include <functional>
+
+// 数据库执行池：SQL 在工作线程上跑，不占用信令/转发所在的主线程
+// - 每个工作线程各自一条 QSqlDatabase 连接（连接不能跨线程使用），线程退出时关闭
+// - 排队加执行中的任务数有上限，满了 submit 直接返回 false，由调用方回"繁忙"
+// - 结果回到主线程交给 done；ctx 非空时随 ctx 销毁作废
+// - 每条连接打开时设好 WAL 相关的 PRAGMA，并缓存按 SQL 文本编译好的语句
+// - 单个任务超过 kSlowMs 记一条慢查询日志（带 label）
+class DbPool : public QObject {
+    Q_OBJECT
+public:
+    using Job  = std::function<QJsonObject(QSqlDatabase&)>;
+    using Done = std::function<void(const QJsonObject&)>;
+
+    DbPool(const QString& dbFile, int threads = 2, int maxQueued = 256, QObject* parent=nullptr);
+    ~DbPool();
+
+    bool submit(Job job, QObject* ctx = nullptr, Done done = Done(), const QString& label = QString());
+    int  pending() const { return inFlight_.loadAcquire(); }
+
+    // 连接级调优：synchronous=NORMAL（WAL 下仍保证不损坏）、页缓存、临时表放内存
+    static void tune(QSqlDatabase& db);
+
+    // 取本线程缓存的预编译语句，没有就 prepare 并缓存；返回的查询与缓存共享，绑定值需重新添加。
+    // 任务结束时池会 finish() 全部缓存语句，释放读快照。不是池内连接时每次现编
+    static QSqlQuery prepared(QSqlDatabase& db, const QString& sql);
+
+signals:
+    void jobFinished(quint64 id, QJsonObject result);   // 工作线程 -> 主线程
+
+private slots:
+    void onJobFinished(quint64 id, QJsonObject result);
+
+private:
+    static constexpr int kSlowMs = 100;
+
+    class Task;
+    struct ThreadConn;
+    struct Waiter {
+        QPointer<QObject> ctx;
+        bool hasCtx = false;
+        Done done;
+    };
+
+    QSqlDatabase threadConnection();
+
+    const QString dbFile_;
+    const int maxQueued_;
+    QAtomicInt inFlight_{0};
+    quint64 nextId_ = 1;
+    QHash<quint64, Waiter> waiters_;           // 只在主线程访问
+    static thread_local ThreadConn* tConn_;   // 本线程的池内连接，prepared() 据此找语句缓存
+    QThreadStorage<ThreadConn*> conns_;        // 须先于 pool_ 构造：pool_ 析构时线程退出要用到
+    QThreadPool pool_;
+};
@@ -2,6 +2,7 @@
 #include "roomhub.h"
 #include "udprelay.h"
 #include "recorder.h"
+#include "dbpool.h"
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QSqlDatabase>
@@ -15,6 +16,7 @@
 #include <QDebug>
 #include <QTime>
 #include <QDateTime>
+#include <QTimer>
 
 static const quint16 Port = 5555;
 static const char* DB_FILE = "users.db";
@@ -107,11 +109,200 @@ static void ensureOrdersTable()
            ")");
 }
 
-static int generateRandomOrderId() {
-    QSqlQuery q;
+// 数据库结构版本记在 PRAGMA user_version 里，启动时把落后的步骤依次补上，每步一个事务
+struct SchemaStep {
+    int version;
+    QStringList sql;
+};
+
+static bool migrateSchema()
+{
+    static const QVector<SchemaStep> steps{
+        // 1: 录制表归入统一迁移（原先由录制服务在首次使用时建），补上按工厂用户/状态/房间/录制的索引
+        {1, {
+            "CREATE TABLE IF NOT EXISTS recordings (id INTEGER PRIMARY KEY AUTOINCREMENT, order_id TEXT, room_id TEXT, started_at INTEGER, ended_at INTEGER, title TEXT)",
+            "CREATE TABLE IF NOT EXISTS recording_files (id INTEGER PRIMARY KEY AUTOINCREMENT, recording_id INTEGER, user TEXT, file_path TEXT, kind TEXT)",
+            "CREATE INDEX IF NOT EXISTS idx_orders_factory_status ON orders(factory_user, status)",
+            "CREATE INDEX IF NOT EXISTS idx_orders_status ON orders(status)",
+            "CREATE INDEX IF NOT EXISTS idx_recordings_room ON recordings(room_id)",
+            "CREATE INDEX IF NOT EXISTS idx_recording_files_rec ON recording_files(recording_id)",
+        }},
+        // 2: 工单变更流水，由触发器随增删改写入，seq 单调递增（AUTOINCREMENT 不复用），只保留最近 4096 条
+        {2, {
+            "CREATE TABLE IF NOT EXISTS order_changes (seq INTEGER PRIMARY KEY AUTOINCREMENT, op TEXT NOT NULL, order_id INTEGER NOT NULL, title TEXT, \"desc\" TEXT, status TEXT, factory_user TEXT)",
+            "CREATE TRIGGER IF NOT EXISTS order_changes_ai AFTER INSERT ON orders BEGIN "
+            "INSERT INTO order_changes(op, order_id, title, \"desc\", status, factory_user) VALUES ('insert', new.id, new.title, new.\"desc\", new.status, new.factory_user); END",
+            "CREATE TRIGGER IF NOT EXISTS order_changes_au AFTER UPDATE ON orders BEGIN "
+            "INSERT INTO order_changes(op, order_id, title, \"desc\", status, factory_user) VALUES ('update', new.id, new.title, new.\"desc\", new.status, new.factory_user); END",
+            "CREATE TRIGGER IF NOT EXISTS order_changes_ad AFTER DELETE ON orders BEGIN "
+            "INSERT INTO order_changes(op, order_id, title, \"desc\", status, factory_user) VALUES ('delete', old.id, old.title, old.\"desc\", old.status, old.factory_user); END",
+            "CREATE TRIGGER IF NOT EXISTS order_changes_trim AFTER INSERT ON order_changes BEGIN "
+            "DELETE FROM order_changes WHERE seq <= new.seq - 4096; END",
+        }},
+    };
+
+    QSqlDatabase db = QSqlDatabase::database();
+    QSqlQuery q(db);
+    if (!q.exec("PRAGMA user_version") || !q.next()) return false;
+    const int current = q.value(0).toInt();
+    q.finish();
+
+    for (const SchemaStep& st : steps) {
+        if (st.version <= current) continue;
+        if (!db.transaction()) {
+            qCritical() << "Schema step" << st.version << "cannot begin transaction:" << db.lastError().text();
+            return false;
+        }
+        for (const QString& sql : st.sql) {
+            if (!q.exec(sql)) {
+                qCritical() << "Schema step" << st.version << "failed:" << q.lastError().text() << sql;
+                db.rollback();
+                return false;
+            }
+        }
+        // 版本号写不进去的话下次启动会重跑这一步，不能悄悄放过
+        if (!q.exec(QString("PRAGMA user_version=%1").arg(st.version))) {
+            qCritical() << "Schema step" << st.version << "cannot record version:" << q.lastError().text();
+            db.rollback();
+            return false;
+        }
+        if (!db.commit()) {
+            qCritical() << "Schema step" << st.version << "commit failed:" << db.lastError().text();
+            db.rollback();
+            return false;
+        }
+        qInfo() << "Schema migrated to version" << st.version;
+    }
+    return true;
+}
+
+// 工单全文检索：orders_fts 为 orders 的外部内容 FTS5 表，由触发器随增删改同步
+// - 优先 trigram 分词：任意子串可查（含中文），与原 LIKE '%kw%' 语义一致，但每个词至少 3 个字符
+// - 不支持 trigram 时退到 unicode61，按词前缀查
+// - SQLite 未编入 FTS5 时保持 LIKE 扫表
+enum class OrderSearch { Like, Trigram, Words };
+static OrderSearch g_orderSearch = OrderSearch::Like;   // 启动时确定，之后只读
+
+static OrderSearch setupOrderSearch()
+{
+    QSqlDatabase db = QSqlDatabase::database();
+    QSqlQuery q(db);
+    if (q.exec("SELECT sql FROM sqlite_master WHERE type='table' AND name='orders_fts'") && q.next())
+        return q.value(0).toString().contains("trigram") ? OrderSearch::Trigram : OrderSearch::Words;
+    q.finish();
+
+    const struct { OrderSearch mode; const char* tokenize; } tries[] = {
+        {OrderSearch::Trigram, "trigram"},
+        {OrderSearch::Words,   "unicode61"},
+    };
+    for (const auto& t : tries) {
+        db.transaction();
+        const QStringList sql{
+            QString("CREATE VIRTUAL TABLE orders_fts USING fts5(title, \"desc\", content='orders', content_rowid='id', tokenize='%1')").arg(t.tokenize),
+            "CREATE TRIGGER IF NOT EXISTS orders_fts_ai AFTER INSERT ON orders BEGIN "
+            "INSERT INTO orders_fts(rowid, title, \"desc\") VALUES (new.id, new.title, new.\"desc\"); END",
+            "CREATE TRIGGER IF NOT EXISTS orders_fts_ad AFTER DELETE ON orders BEGIN "
+            "INSERT INTO orders_fts(orders_fts, rowid, title, \"desc\") VALUES ('delete', old.id, old.title, old.\"desc\"); END",
+            "CREATE TRIGGER IF NOT EXISTS orders_fts_au AFTER UPDATE OF title, \"desc\" ON orders BEGIN "
+            "INSERT INTO orders_fts(orders_fts, rowid, title, \"desc\") VALUES ('delete', old.id, old.title, old.\"desc\"); "
+            "INSERT INTO orders_fts(rowid, title, \"desc\") VALUES (new.id, new.title, new.\"desc\"); END",
+            "INSERT INTO orders_fts(orders_fts) VALUES ('rebuild')",
+        };
+        bool ok = true;
+        for (const QString& s : sql) {
+            if (!q.exec(s)) { ok = false; break; }
+        }
+        if (ok && db.commit()) {
+            qInfo() << "Order full-text index built, tokenizer =" << t.tokenize;
+            return t.mode;
+        }
+        qWarning() << "FTS5 tokenizer" << t.tokenize << "unavailable:" << q.lastError().text();
+        db.rollback();
+    }
+    return OrderSearch::Like;
+}
+
+// 关键字转 FTS5 查询：按空白拆词，词间为与；返回空串表示这次只能走 LIKE
+static QString orderMatchExpr(const QString& keyword)
+{
+    const QStringList terms = keyword.split(QRegularExpression("\\s+"), QString::SkipEmptyParts);
+    QStringList parts;
+    for (QString t : terms) {
+        if (g_orderSearch == OrderSearch::Trigram && t.size() < 3) return QString();
+        t.replace('"', "\"\"");
+        parts << (g_orderSearch == OrderSearch::Words ? QString("\"%1\"*").arg(t) : QString("\"%1\"").arg(t));
+    }
+    return parts.join(' ');
+}
+
+// 列表接口的键集分页：请求带 limit(>0) 时按 id 升序取 after 之后的 limit 行，
+// 还有下一页时应答带 next（本页最后一行的 id），客户端原样作为下一次的 after。
+// 按相关度排的列表用 (rank, id) 作键：应答另带 next_rank，客户端作为 after_rank 带回
+struct ListPage {
+    static constexpr int kMaxLimit = 500;
+    int limit = 0;
+    qint64 after = 0;
+    bool   hasRank = false;
+    double afterRank = 0;
+
+    explicit ListPage(const QJsonObject& req)
+        : limit(qBound(0, req.value("limit").toInt(), int(kMaxLimit))),
+          after(qint64(req.value("after").toDouble())),
+          hasRank(req.contains("after_rank")),
+          afterRank(req.value("after_rank").toDouble()) {}
+    bool on() const { return limit > 0; }
+    // 追加在全部 WHERE 条件之后
+    QString clause(const QString& idCol) const {
+        return on() ? QString(" AND %1 > ? ORDER BY %1 LIMIT ?").arg(idCol) : QString();
+    }
+    void bind(QSqlQuery& q) const {
+        if (!on()) return;
+        q.addBindValue(after);
+        q.addBindValue(limit);
+    }
+    // rankExpr 升序、同分按 id 升序；第一页没有 after_rank，不加游标条件
+    QString rankClause(const QString& rankExpr, const QString& idCol) const {
+        QString sql;
+        if (on() && hasRank) sql = QString(" AND (%1 > ? OR (%1 = ? AND %2 > ?))").arg(rankExpr, idCol);
+        sql += QString(" ORDER BY %1, %2").arg(rankExpr, idCol);
+        if (on()) sql += " LIMIT ?";
+        return sql;
+    }
+    void bindRank(QSqlQuery& q) const {
+        if (!on()) return;
+        if (hasRank) {
+            q.addBindValue(afterRank);
+            q.addBindValue(afterRank);
+            q.addBindValue(after);
+        }
+        q.addBindValue(limit);
+    }
+    void finish(QJsonObject& rep, int rows, qint64 lastId) const {
+        if (on() && rows == limit) rep["next"] = double(lastId);
+    }
+    void finishRank(QJsonObject& rep, int rows, qint64 lastId, double lastRank) const {
+        if (on() && rows == limit) {
+            rep["next"] = double(lastId);
+            rep["next_rank"] = lastRank;
+        }
+    }
+    // 应答里的续页位置写回请求，用于流式取下一块
+    static void advance(QJsonObject& req, const QJsonObject& rep) {
+        req["after"] = rep.value("next");
+        if (rep.contains("next_rank")) req["after_rank"] = rep.value("next_rank");
+    }
+};
+
+static int generateRandomOrderId(QSqlDatabase& db) {
+    // 在数据库池的工作线程上调用，qrand 的种子是每线程各自的
+    static thread_local bool seeded = false;
+    if (!seeded) {
+        qsrand(uint(QDateTime::currentMSecsSinceEpoch()) ^ uint(reinterpret_cast<quintptr>(QThread::currentThreadId())));
+        seeded = true;
+    }
+    QSqlQuery q = DbPool::prepared(db, "SELECT 1 FROM orders WHERE id=?");
     for (int i = 0; i < 100; ++i) {
         int id = 1000 + qrand() % 9000;
-        q.prepare("SELECT 1 FROM orders WHERE id=?");
         q.addBindValue(id);
         q.exec();
         if (!q.next()) return id;
@@ -127,6 +318,13 @@ public:
     bool start() {
         if (!initDb()) return false;
         ensureOrdersTable();
+        if (!migrateSchema()) return false;
+        g_orderSearch = setupOrderSearch();
+        {
+            QSqlDatabase db = QSqlDatabase::database();
+            published_ = latestOrderChange(db);
+        }
+        db_ = new DbPool(QString::fromLatin1(DB_FILE), kDbThreads, kDbMaxQueued, this);
 
         m_server = new QTcpServer(this);
         connect(m_server, &QTcpServer::newConnection, this, &AuthServer::onNewConnection);
@@ -138,32 +336,173 @@ public:
         return true;
     }
 
+    DbPool* dbPool() const { return db_; }
+
+private:
+    static constexpr int kDbThreads   = 2;    // SQLite 写入本身串行，多开线程主要让慢查询不堵住其它连接
+    static constexpr int kDbMaxQueued = 256;
+    static constexpr int kMaxPerConn  = 64;   // 单个连接排队上限，超出的直接回繁忙
+    static constexpr int kStreamChunk = 200;  // 流式列表每块的条数
+    static constexpr int kReplayMax   = 1000; // 订阅续传时最多补发的变更数，落后更多直接让客户端全量重载
+    static constexpr int kRecentKept  = 256;  // 主线程留着最近推送过的变更，补给刚完成订阅的连接
+
+    struct Request {
+        QJsonObject req;
+        QJsonObject reply;   // 非空表示无需查库，按序直接回
+        QJsonValue  id;       // 客户端的 req_id，原样带回
+        bool stream = false; // 列表分块流式返回
+    };
+    struct Conn {
+        QQueue<Request> queue;
+        bool busy = false;   // 有一个请求在数据库池里
+        // 工单变更订阅
+        bool    subscribed = false;
+        QString feedUser;    // 工厂端只推自己的工单；专家端为空，推全部
+        qint64  feedSeq = 0; // 已推给该连接（或已确认与它无关）的最后一个 seq
+    };
+
 private slots:
     void onNewConnection() {
         while (m_server->hasPendingConnections()) {
             QTcpSocket *sock = m_server->nextPendingConnection();
+            conns_.insert(sock, Conn());
             connect(sock, &QTcpSocket::readyRead, this, [this, sock](){
+                Conn& c = conns_[sock];
                 while (sock->canReadLine()) {
                     QByteArray line = sock->readLine().trimmed();
                     if (line.isEmpty()) continue;
                     QJsonParseError pe{};
                     QJsonDocument doc = QJsonDocument::fromJson(line, &pe);
-                    QJsonObject reply;
+                    Request r;
+                    // 请求带 req_id 时原样带回：客户端在一条长连接上同时挂多个请求，按 req_id 认领应答；
+                    // "id" 是业务字段（如工单号），不能拿来做关联。繁忙应答也要带上，否则会被记到别的请求头上
+                    if (doc.isObject()) r.id = doc.object().value("req_id");
                     if (pe.error != QJsonParseError::NoError || !doc.isObject()) {
-                        reply = makeReply(false, "bad json");
+                        r.reply = makeReply(false, "bad json");
+                    } else if (c.queue.size() >= kMaxPerConn) {
+                        r.reply = makeReply(false, QStringLiteral("服务器繁忙"));
                     } else {
-                        reply = handle(doc.object());
+                        r.req = doc.object();
+                        // 流式：同一列表按 kStreamChunk 分页，每页一行应答（NDJSON），带 "more"，最后一行 more=false
+                        r.stream = r.req.value("stream").toBool();
+                        if (r.stream && !r.req.contains("limit")) r.req["limit"] = kStreamChunk;
                     }
-                    QByteArray out = QJsonDocument(reply).toJson(QJsonDocument::Compact) + "\n";
-                    sock->write(out);
-                    sock->flush();
+                    c.queue.enqueue(r);
                 }
+                pump(sock);
             });
             connect(sock, &QTcpSocket::disconnected, sock, &QTcpSocket::deleteLater);
+            connect(sock, &QObject::destroyed, this, [this, sock](){ conns_.remove(sock); });
         }
     }
 
 private:
+    // 同一连接上的请求依次交给数据库池：应答顺序与请求一致，先写后读的流水线请求也能读到自己写的结果；
+    // 不同连接之间并行
+    void pump(QTcpSocket* sock) {
+        auto it = conns_.find(sock);
+        if (it == conns_.end() || it->busy) return;
+        while (!it->queue.isEmpty()) {
+            Request r = it->queue.dequeue();
+            if (r.reply.isEmpty()) {
+                const QJsonObject req = r.req;
+                const bool ok = db_->submit([req](QSqlDatabase& db){ return handle(db, req); }, sock,
+                                            [this, sock, r](const QJsonObject& rep){
+                    Request done = r;
+                    done.reply = rep;
+                    const bool more = r.stream && rep.contains("next");
+                    if (r.stream) done.reply["more"] = more;
+                    write(sock, done);
+                    const QString action = r.req.value("action").toString();
+                    const bool ok = rep.value("ok").toBool();
+                    if (ok && action == "subscribe_orders") subscribe(sock, r.req, rep);
+                    else if (ok && (action == "new_order" || action == "update_order" || action == "delete_order")) pollFeed();
+                    auto c = conns_.find(sock);
+                    if (c == conns_.end()) return;
+                    if (more) {
+                        // 下一块排到队首：与后续请求的先后顺序不变，各块之间也让出主线程
+                        Request next = r;
+                        ListPage::advance(next.req, rep);
+                        c->queue.prepend(next);
+                    }
+                    c->busy = false;
+                    pump(sock);
+                }, req.value("action").toString());
+                if (ok) { it->busy = true; return; }
+                r.reply = makeReply(false, QStringLiteral("服务器繁忙"));
+            }
+            write(sock, r);
+        }
+    }
+
+    // 订阅生效：从应答里的 seq 接着推；应答查库到这里之间主线程已推出的变更从 recent_ 补上
+    void subscribe(QTcpSocket* sock, const QJsonObject& req, const QJsonObject& rep) {
+        auto c = conns_.find(sock);
+        if (c == conns_.end()) return;
+        c->subscribed = true;
+        c->feedUser = req.value("role").toString() == "factory" ? req.value("username").toString() : QString();
+        c->feedSeq = qint64(rep.value("seq").toDouble());
+        if (c->feedSeq >= published_) return;
+        if (recent_.isEmpty() || qint64(recent_.first().value("seq").toDouble()) > c->feedSeq + 1) {
+            c->feedSeq = published_;
+            sendEvent(sock, QJsonObject{{"event", "orders_reset"}, {"seq", double(published_)}});
+            return;
+        }
+        for (const QJsonObject& ch : recent_) deliver(sock, *c, ch);
+    }
+
+    // 有写入提交后到库里取新的变更流水，按 seq 顺序推给订阅者；同一时刻只有一个取流水的任务
+    void pollFeed() {
+        if (feedBusy_) { feedDirty_ = true; return; }
+        feedBusy_ = true;
+        feedDirty_ = false;
+        const qint64 after = published_;
+        const bool ok = db_->submit([after](QSqlDatabase& db){ return readOrderChanges(db, after, -1); }, this,
+                                    [this](const QJsonObject& rep){
+            for (const QJsonValue& v : rep.value("changes").toArray()) publish(v.toObject());
+            feedBusy_ = false;
+            if (feedDirty_) pollFeed();
+        }, QStringLiteral("order_feed"));
+        if (!ok) {
+            // 数据库池满：稍后再取，流水在库里不会丢
+            feedBusy_ = false;
+            QTimer::singleShot(100, this, [this](){ pollFeed(); });
+        }
+    }
+
+    void publish(const QJsonObject& ch) {
+        const qint64 seq = qint64(ch.value("seq").toDouble());
+        if (seq <= published_) return;
+        published_ = seq;
+        recent_.append(ch);
+        if (recent_.size() > kRecentKept) recent_.removeFirst();
+        for (auto it = conns_.begin(); it != conns_.end(); ++it)
+            if (it->subscribed) deliver(it.key(), *it, ch);
+    }
+
+    // 与该连接无关的变更不推，也不推进 feedSeq；推出去的带 prev（该连接上一条的 seq），客户端据此发现缺口
+    static void deliver(QTcpSocket* sock, Conn& c, const QJsonObject& ch) {
+        const qint64 seq = qint64(ch.value("seq").toDouble());
+        if (seq <= c.feedSeq) return;
+        const QJsonObject order = ch.value("order").toObject();
+        if (!c.feedUser.isEmpty() && order.value("factory_user").toString() != c.feedUser) return;
+        QJsonObject ev = ch;
+        ev["event"] = "order_change";
+        ev["prev"] = double(c.feedSeq);
+        c.feedSeq = seq;
+        sendEvent(sock, ev);
+    }
+
+    static void sendEvent(QTcpSocket* sock, const QJsonObject& ev) {
+        sock->write(QJsonDocument(ev).toJson(QJsonDocument::Compact) + "\n");
+    }
+
+    static void write(QTcpSocket* sock, const Request& r) {
+        QJsonObject reply = r.reply;
+        if (!r.id.isUndefined()) reply["req_id"] = r.id;
+        sock->write(QJsonDocument(reply).toJson(QJsonDocument::Compact) + "\n");
+    }
+
     bool initDb() {
         QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
         db.setDatabaseName(DB_FILE);
@@ -172,6 +511,11 @@ private:
             return false;
         }
         QSqlQuery q;
+        // WAL：读不阻塞写，数据库池的多条连接可以同时查询；日志模式写进文件头，只需设一次
+        if (!q.exec("PRAGMA journal_mode=WAL") || !q.next() || q.value(0).toString() != "wal")
+            qWarning() << "WAL not enabled, journal_mode =" << q.value(0).toString();
+        q.finish();
+        DbPool::tune(db);
         if (!q.exec("CREATE TABLE IF NOT EXISTS expert_users ( username TEXT PRIMARY KEY, password TEXT NOT NULL );")) {
             qCritical() << "Create expert_users failed:" << q.lastError().text();
             return false;
@@ -186,17 +530,17 @@ private:
         return true;
     }
 
-    bool existsInAny(const QString &username) {
-        QSqlQuery q;
-        q.prepare("SELECT 1 FROM expert_users WHERE username=? "
-                  "UNION ALL SELECT 1 FROM factory_users WHERE username=? LIMIT 1");
+    // 以下在 DbPool 工作线程上执行，只用传入的本线程连接
+    static bool existsInAny(QSqlDatabase& db, const QString &username) {
+        QSqlQuery q = DbPool::prepared(db, "SELECT 1 FROM expert_users WHERE username=? "
+                                           "UNION ALL SELECT 1 FROM factory_users WHERE username=? LIMIT 1");
         q.addBindValue(username);
         q.addBindValue(username);
         if (!q.exec()) return false;
         return q.next();
     }
 
-    QJsonObject handle(const QJsonObject &req) {
+    static QJsonObject handle(QSqlDatabase& db, const QJsonObject &req) {
         const QString action = req.value("action").toString();
         if (action == "register" || action == "login") {
             const QString role = req.value("role").toString();
@@ -211,9 +555,9 @@ private:
             }
 
             if (action == "register") {
-                return doRegister(username, role, password);
+                return doRegister(db, username, role, password);
             } else if (action == "login") {
-                return doLogin(username, role, password);
+                return doLogin(db, username, role, password);
             } else {
                 return makeReply(false, "unknown action");
             }
@@ -222,10 +566,9 @@ private:
             QString title = req.value("title").toString();
             QString desc = req.value("desc").toString();
             QString factory_user = req.value("factory_user").toString();
-            int id = generateRandomOrderId();
+            int id = generateRandomOrderId(db);
             if (id < 0) return makeReply(false, QStringLiteral("无法分配工单号"));
-            QSqlQuery q;
-            q.prepare("INSERT INTO orders (id, title, desc, status, factory_user) VALUES (?, ?, ?, ?, ?)");
+            QSqlQuery q = DbPool::prepared(db, "INSERT INTO orders (id, title, desc, status, factory_user) VALUES (?, ?, ?, ?, ?)");
             q.addBindValue(id);
             q.addBindValue(title);
             q.addBindValue(desc);
@@ -238,20 +581,30 @@ private:
             QString username = req.value("username").toString();
             QString keyword = req.value("keyword").toString();
             QString status = req.value("status").toString();
-            QString sql = "SELECT id, title, desc, status, factory_user FROM orders WHERE 1=1";
+            // 有关键字且全文索引可用时从 orders_fts 出发，按 bm25 相关度排序；否则 LIKE 扫表
+            const QString match = (keyword.isEmpty() || g_orderSearch == OrderSearch::Like)
+                                  ? QString() : orderMatchExpr(keyword.trimmed());
+            QString sql = match.isEmpty()
+                ? "SELECT o.id, o.title, o.desc, o.status, o.factory_user FROM orders o WHERE 1=1"
+                : "SELECT o.id, o.title, o.desc, o.status, o.factory_user, bm25(orders_fts) "
+                  "FROM orders_fts JOIN orders o ON o.id = orders_fts.rowid WHERE orders_fts MATCH ?";
             if (role == "factory" && !username.isEmpty()) {
-                sql += " AND factory_user=?";
+                sql += " AND o.factory_user=?";
             }
-            if (!keyword.isEmpty()) {
-                sql += " AND (title LIKE ? OR desc LIKE ?)";
+            if (!keyword.isEmpty() && match.isEmpty()) {
+                sql += " AND (o.title LIKE ? OR o.desc LIKE ?)";
             }
             if (!status.isEmpty() && status != QStringLiteral("全部")) {
-                sql += " AND status=?";
+                sql += " AND o.status=?";
             }
-            QSqlQuery q;
-            q.prepare(sql);
+            // 全文检索按 bm25 相关度排，分页游标为 (rank, id)；其余按 id 分页
+            const ListPage page(req);
+            if (!match.isEmpty()) sql += page.rankClause("bm25(orders_fts)", "o.id");
+            else sql += page.clause("o.id");
+            QSqlQuery q = DbPool::prepared(db, sql);
+            if (!match.isEmpty()) q.addBindValue(match);
             if (role == "factory" && !username.isEmpty()) q.addBindValue(username);
-            if (!keyword.isEmpty()) {
+            if (!keyword.isEmpty() && match.isEmpty()) {
                 QString like = "%" + keyword + "%";
                 q.addBindValue(like);
                 q.addBindValue(like);
@@ -259,8 +612,11 @@ private:
             if (!status.isEmpty() && status != QStringLiteral("全部")) {
                 q.addBindValue(status);
             }
+            if (!match.isEmpty()) page.bindRank(q);
+            else page.bind(q);
             q.exec();
             QJsonArray arr;
+            double lastRank = 0;
             while (q.next()) {
                 QJsonObject o;
                 o["id"] = q.value(0).toInt();
@@ -268,17 +624,22 @@ private:
                 o["desc"] = q.value(2).toString();
                 o["status"] = q.value(3).toString();
                 o["factory_user"] = q.value(4).toString();
+                if (!match.isEmpty()) lastRank = q.value(5).toDouble();
                 arr.append(o);
             }
             QJsonObject rep;
             rep["ok"] = true;
             rep["orders"] = arr;
+            if (!arr.isEmpty()) {
+                const qint64 lastId = arr.last().toObject().value("id").toInt();
+                if (!match.isEmpty()) page.finishRank(rep, arr.size(), lastId, lastRank);
+                else page.finish(rep, arr.size(), lastId);
+            }
             return rep;
         } else if (action == "update_order") {
             int id = req.value("id").toInt();
             QString status = req.value("status").toString();
-            QSqlQuery q;
-            q.prepare("UPDATE orders SET status=? WHERE id=?");
+            QSqlQuery q = DbPool::prepared(db, "UPDATE orders SET status=? WHERE id=?");
             q.addBindValue(status);
             q.addBindValue(id);
             if (q.exec()) return makeReply(true, "ok");
@@ -286,24 +647,27 @@ private:
         } else if (action == "delete_order") {
             int id = req.value("id").toInt();
             QString username = req.value("username").toString();
-            QSqlQuery q;
-            q.prepare("SELECT 1 FROM orders WHERE id=? AND factory_user=?");
+            QSqlQuery q = DbPool::prepared(db, "SELECT 1 FROM orders WHERE id=? AND factory_user=?");
             q.addBindValue(id);
             q.addBindValue(username);
             if (!q.exec() || !q.next()) {
                 return makeReply(false, QStringLiteral("只能销毁自己创建的工单"));
             }
-            q.prepare("DELETE FROM orders WHERE id=?");
+            q = DbPool::prepared(db, "DELETE FROM orders WHERE id=?");
             q.addBindValue(id);
             if (q.exec()) return makeReply(true, "ok");
             else return makeReply(false, q.lastError().text());
+        } else if (action == "subscribe_orders") {
+            return subscribeOrders(db, req);
         } else if (action == "get_recordings") {
             QString roomId = req.value("room_id").toString();
-            QString sql = "SELECT id, order_id, room_id, started_at, ended_at, title FROM recordings";
-            if (!roomId.isEmpty()) sql += " WHERE room_id=?";
-            QSqlQuery q;
-            if (!roomId.isEmpty()) { q.prepare(sql); q.addBindValue(roomId); }
-            else { q.prepare(sql); }
+            QString sql = "SELECT id, order_id, room_id, started_at, ended_at, title FROM recordings WHERE 1=1";
+            if (!roomId.isEmpty()) sql += " AND room_id=?";
+            const ListPage page(req);
+            sql += page.clause("id");
+            QSqlQuery q = DbPool::prepared(db, sql);
+            if (!roomId.isEmpty()) q.addBindValue(roomId);
+            page.bind(q);
             if (!q.exec()) return makeReply(false, q.lastError().text());
             QJsonArray items;
             while (q.next()) {
@@ -316,22 +680,25 @@ private:
                 o["title"] = q.value(5).toString();
                 items.append(o);
             }
-            QJsonObject rep; rep["ok"] = true; rep["items"] = items; return rep;
+            QJsonObject rep; rep["ok"] = true; rep["items"] = items;
+            if (!items.isEmpty()) page.finish(rep, items.size(), items.last().toObject().value("id").toInt());
+            return rep;
         } else if (action == "get_recording_files") {
             int recordingId = req.value("recording_id").toInt();
             QString roomId = req.value("room_id").toString();
             QString sql = "SELECT f.id, f.recording_id, f.user, f.file_path, f.kind "
                           "FROM recording_files f JOIN recordings r ON f.recording_id=r.id";
-            QString where;
+            QString where = " WHERE 1=1";
             if (recordingId > 0) {
-                where = " WHERE f.recording_id=?";
+                where += " AND f.recording_id=?";
             } else if (!roomId.isEmpty()) {
-                where = " WHERE r.room_id=?";
+                where += " AND r.room_id=?";
             }
-            QSqlQuery q;
-            q.prepare(sql + where);
+            const ListPage page(req);
+            QSqlQuery q = DbPool::prepared(db, sql + where + page.clause("f.id"));
             if (recordingId > 0) q.addBindValue(recordingId);
             else if (!roomId.isEmpty()) q.addBindValue(roomId);
+            page.bind(q);
 
             if (!q.exec()) return makeReply(false, q.lastError().text());
 
@@ -345,25 +712,85 @@ private:
                 o["kind"] = q.value(4).toString();
                 files.append(o);
             }
-            QJsonObject rep; rep["ok"] = true; rep["files"] = files; return rep;
+            QJsonObject rep; rep["ok"] = true; rep["files"] = files;
+            if (!files.isEmpty()) page.finish(rep, files.size(), files.last().toObject().value("id").toInt());
+            return rep;
         }
         return makeReply(false, "unknown action");
     }
 
-    QJsonObject doRegister(const QString &user, const QString &role, const QString &pass) {
+    static qint64 latestOrderChange(QSqlDatabase& db) {
+        QSqlQuery q = DbPool::prepared(db, "SELECT COALESCE(MAX(seq), 0) FROM order_changes");
+        return (q.exec() && q.next()) ? q.value(0).toLongLong() : 0;
+    }
+
+    // seq > after 的变更流水，按 seq 升序；limit < 0 不限
+    static QJsonObject readOrderChanges(QSqlDatabase& db, qint64 after, int limit) {
+        QSqlQuery q = DbPool::prepared(db, "SELECT seq, op, order_id, title, \"desc\", status, factory_user "
+                                           "FROM order_changes WHERE seq > ? ORDER BY seq LIMIT ?");
+        q.addBindValue(after);
+        q.addBindValue(limit);
+        if (!q.exec()) return makeReply(false, q.lastError().text());
+        QJsonArray changes;
+        while (q.next()) {
+            QJsonObject o;
+            o["id"] = q.value(2).toInt();
+            o["title"] = q.value(3).toString();
+            o["desc"] = q.value(4).toString();
+            o["status"] = q.value(5).toString();
+            o["factory_user"] = q.value(6).toString();
+            changes.append(QJsonObject{{"seq", double(q.value(0).toLongLong())},
+                                       {"op", q.value(1).toString()}, {"order", o}});
+        }
+        QJsonObject rep; rep["ok"] = true; rep["changes"] = changes;
+        return rep;
+    }
+
+    // 订阅工单变更：应答带当前 seq，之后的变更由服务端主动推送（"event":"order_change"）。
+    // 带 since 时补发 since 之后与该用户有关的变更；流水已被裁掉、落后过多或库被重建时回 reset，客户端全量重载。
+    // since 为 0 也是合法的续订位置（订阅时流水还是空的），只有不带 since 才算新订阅
+    static QJsonObject subscribeOrders(QSqlDatabase& db, const QJsonObject& req) {
+        const qint64 since = qint64(req.value("since").toDouble(-1));
+        const QString user = req.value("role").toString() == "factory" ? req.value("username").toString() : QString();
+        QJsonObject rep{{"ok", true}};
+        if (since < 0) {
+            rep["seq"] = double(latestOrderChange(db));
+            return rep;
+        }
+        QJsonObject got = readOrderChanges(db, since - 1, kReplayMax + 2);
+        if (!got.value("ok").toBool()) return got;
+        const QJsonArray all = got.value("changes").toArray();
+        // since 之后的流水完整：第一条应是 since 本身；since 为 0 时流水要么还空着，要么从 1 开始没被裁过
+        const qint64 first = all.isEmpty() ? 0 : qint64(all.first().toObject().value("seq").toDouble());
+        const int skip = since > 0 ? 1 : 0;
+        const bool intact = since > 0 ? first == since : (all.isEmpty() || first == 1);
+        if (!intact || all.size() - skip > kReplayMax) {
+            rep["reset"] = true;
+            rep["seq"] = double(latestOrderChange(db));
+            return rep;
+        }
+        QJsonArray changes;
+        for (int i = skip; i < all.size(); ++i) {
+            const QJsonObject ch = all.at(i).toObject();
+            if (user.isEmpty() || ch.value("order").toObject().value("factory_user").toString() == user)
+                changes.append(ch);
+        }
+        rep["changes"] = changes;
+        rep["seq"] = all.isEmpty() ? double(since) : all.last().toObject().value("seq");
+        return rep;
+    }
+
+    static QJsonObject doRegister(QSqlDatabase& db, const QString &user, const QString &role, const QString &pass) {
         QString perr;
         if (!isValidPasswordFormat(pass, &perr)) {
             return makeReply(false, perr);
         }
-        if (existsInAny(user)) {
+        if (existsInAny(db, user)) {
             return makeReply(false, QStringLiteral("用户已存在"));
         }
-        QSqlQuery q;
-        if (role == "expert") {
-            q.prepare("INSERT INTO expert_users(username, password) VALUES(?, ?)");
-        } else {
-            q.prepare("INSERT INTO factory_users(username, password) VALUES(?, ?)");
-        }
+        QSqlQuery q = DbPool::prepared(db, role == "expert"
+            ? QStringLiteral("INSERT INTO expert_users(username, password) VALUES(?, ?)")
+            : QStringLiteral("INSERT INTO factory_users(username, password) VALUES(?, ?)"));
         q.addBindValue(user);
         q.addBindValue(hashPass(pass));
         if (!q.exec()) {
@@ -373,13 +800,10 @@ private:
         return makeReply(true, "ok");
     }
 
-    QJsonObject doLogin(const QString &user, const QString &role, const QString &pass) {
-        QSqlQuery q;
-        if (role == "expert") {
-            q.prepare("SELECT 1 FROM expert_users WHERE username=? AND password=? LIMIT 1");
-        } else {
-            q.prepare("SELECT 1 FROM factory_users WHERE username=? AND password=? LIMIT 1");
-        }
+    static QJsonObject doLogin(QSqlDatabase& db, const QString &user, const QString &role, const QString &pass) {
+        QSqlQuery q = DbPool::prepared(db, role == "expert"
+            ? QStringLiteral("SELECT 1 FROM expert_users WHERE username=? AND password=? LIMIT 1")
+            : QStringLiteral("SELECT 1 FROM factory_users WHERE username=? AND password=? LIMIT 1"));
         q.addBindValue(user);
         q.addBindValue(hashPass(pass));
         if (!q.exec()) {
@@ -395,6 +819,14 @@ private:
 
 private:
     QTcpServer *m_server = nullptr;
+    DbPool *db_ = nullptr;
+    QHash<QTcpSocket*, Conn> conns_;
+
+    // 工单变更推送
+    qint64 published_ = 0;           // 已推送的最大 seq
+    QVector<QJsonObject> recent_;    // 最近推送过的变更，seq 升序
+    bool feedBusy_  = false;
+    bool feedDirty_ = false;
 };
 
 #include "main.moc"
@@ -430,10 +862,12 @@ int main(int argc, char** argv)
     if (!udp.start(udpPort)) {
         return 1;
     }
+    QObject::connect(&hub, &RoomHub::screenSubscriptionChanged, &udp, &UdpRelay::setScreenSubscription);
 
     // 录制服务
     RecorderService recorder;
     recorder.init(/*udpPort*/ udpPort, /*kbRoot*/ QStringLiteral("knowledge"));
+    recorder.setDbPool(auth.dbPool());
     hub.setRecorder(&recorder);
 
     return app.exec();
@@ -6,6 +6,7 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
+#include "dbpool.h"
 #include <QStandardPaths>
 #include <QFileInfo>
 #include <QDebug>
@@ -236,8 +237,8 @@ void RecorderStream::writeFrame(const QImage& frame)
 }
 
 // ========== RecorderRoom ==========
-RecorderRoom::RecorderRoom(const QString& roomId, quint16 udpPort, QObject* parent)
-    : QObject(parent), roomId_(roomId), udpPort_(udpPort)
+RecorderRoom::RecorderRoom(const QString& roomId, quint16 udpPort, DbPool* db, QObject* parent)
+    : QObject(parent), roomId_(roomId), udpPort_(udpPort), db_(db)
 {
     outDir_ = QDir("knowledge").filePath(roomId_);
     QDir().mkpath(outDir_);
@@ -277,6 +278,10 @@ void RecorderRoom::membersUpdated(const QStringList& members)
     QSet<QString> next = QSet<QString>::fromList(members);
     currentMembers_ = next;
 
+    // 离开的人的增量解码状态作废，重新入会后要等新的关键帧，不能套在旧关键帧上
+    for (auto it = camDec_.begin(); it != camDec_.end(); )
+        it = next.contains(it.key()) ? std::next(it) : camDec_.erase(it);
+
     for (const QString& u : currentMembers_) {
         ensureStream(u);
         if (!streams_[u]->isActive()) streams_[u]->start();
@@ -296,19 +301,17 @@ void RecorderRoom::onTcpPacket(const Packet& p)
 
         qInfo() << "[rec][tcp]" << roomId_ << "recv" << media << "frame from" << sender << "bytes=" << p.bin.size();
 
-        QBuffer buf(const_cast<QByteArray*>(&p.bin));
-        buf.open(QIODevice::ReadOnly);
-        QImageReader r(&buf);
-        r.setAutoTransform(true);
-        QImage img = r.read().convertToFormat(QImage::Format_RGB32);
+        QImage img;
+        if (media == "screen") img = VideoCodec::decodeJpeg(p.bin);
+        else camDec_[sender].decode(p.json, p.bin, &img);
 
         if (img.isNull()) {
+            // 增量帧在关键帧到达前解不出来属正常情况
+            if (p.json.value("frame").toString() == "delta") return;
             qWarning().noquote() << "[rec][tcp]" << roomId_
                                  << "decode failed for" << media
                                  << "sender=" << sender
-                                 << "bytes=" << p.bin.size()
-                                 << "fmt=" << QString::fromLatin1(r.format())
-                                 << "err=" << r.errorString();
+                                 << "bytes=" << p.bin.size();
             return;
         }
 
@@ -320,7 +323,12 @@ void RecorderRoom::onTcpPacket(const Packet& p)
             streams_[sender]->onCameraFrame(img);
         }
     } else if (p.type == MSG_ANNOT) {
-        handleAnnot(p.json);
+        handleAnnot(p.json, p.bin);
+    } else if (p.type == MSG_CONTROL) {
+        // 关摄像头后再开，编码端从关键帧重新开始；旧解码状态一并丢掉
+        const QString kind = p.json.value("kind").toString();
+        if ((kind == "视频" || kind == "video") && p.json.value("state").toString() == "off")
+            camDec_.remove(p.json.value("sender").toString());
     }
 }
 
@@ -332,36 +340,43 @@ void RecorderRoom::finalizeAndClose()
     }
     streams_.clear();
 
-    QSqlQuery q;
-    q.exec("CREATE TABLE IF NOT EXISTS recordings (id INTEGER PRIMARY KEY AUTOINCREMENT, order_id TEXT, room_id TEXT, started_at INTEGER, ended_at INTEGER, title TEXT)");
-    q.exec("CREATE TABLE IF NOT EXISTS recording_files (id INTEGER PRIMARY KEY AUTOINCREMENT, recording_id INTEGER, user TEXT, file_path TEXT, kind TEXT)");
-
-    QSqlQuery qi;
-    qi.prepare("INSERT INTO recordings(order_id, room_id, started_at, ended_at, title) VALUES(?, ?, ?, ?, ?)");
-    qi.addBindValue(roomId_);
-    qi.addBindValue(roomId_);
-    const qint64 now = QDateTime::currentMSecsSinceEpoch();
-    qi.addBindValue(now);
-    qi.addBindValue(now);
-    qi.addBindValue(QString("会议录制 %1").arg(roomId_));
-    if (!qi.exec()) {
-        qWarning() << "[rec] insert recordings failed:" << qi.lastError();
-        return;
-    }
-    int recId = qi.lastInsertId().toInt();
-
-    QDir dir(outDir_);
-    const QStringList files = dir.entryList(QStringList() << "*.mp4", QDir::Files);
-    for (const QString& f : files) {
-        QSqlQuery qf;
-        qf.prepare("INSERT INTO recording_files(recording_id, user, file_path, kind) VALUES(?, ?, ?, ?)");
-        qf.addBindValue(recId);
-        QString u = f; u.chop(4); u = u.mid(u.indexOf('_')+1);
-        qf.addBindValue(u);
-        qf.addBindValue(dir.filePath(f));
-        qf.addBindValue("video");
-        if (!qf.exec()) qWarning() << "[rec] insert file failed:" << qf.lastError();
-    }
+    // 表由服务端启动时的统一迁移建立；入库交给数据库池，不占转发线程
+    const QString roomId = roomId_;
+    const QString outDir = outDir_;
+    auto job = [roomId, outDir](QSqlDatabase& db) {
+        QSqlQuery qi = DbPool::prepared(db, "INSERT INTO recordings(order_id, room_id, started_at, ended_at, title) VALUES(?, ?, ?, ?, ?)");
+        qi.addBindValue(roomId);
+        qi.addBindValue(roomId);
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        qi.addBindValue(now);
+        qi.addBindValue(now);
+        qi.addBindValue(QString("会议录制 %1").arg(roomId));
+        if (!qi.exec()) {
+            qWarning() << "[rec] insert recordings failed:" << qi.lastError();
+            return QJsonObject{{"ok", false}};
+        }
+        int recId = qi.lastInsertId().toInt();
+
+        QDir dir(outDir);
+        const QStringList files = dir.entryList(QStringList() << "*.mp4", QDir::Files);
+        db.transaction();
+        QSqlQuery qf = DbPool::prepared(db, "INSERT INTO recording_files(recording_id, user, file_path, kind) VALUES(?, ?, ?, ?)");
+        for (const QString& f : files) {
+            qf.addBindValue(recId);
+            QString u = f; u.chop(4); u = u.mid(u.indexOf('_')+1);
+            qf.addBindValue(u);
+            qf.addBindValue(dir.filePath(f));
+            qf.addBindValue("video");
+            if (!qf.exec()) qWarning() << "[rec] insert file failed:" << qf.lastError();
+        }
+        db.commit();
+        return QJsonObject{{"ok", true}, {"recording_id", recId}};
+    };
+
+    if (db_ && db_->submit(job)) return;
+    // 没有数据库池或池已满：退回主线程同步写，录制记录不能丢
+    QSqlDatabase db = QSqlDatabase::database();
+    job(db);
 }
 
 void RecorderRoom::ensureStream(const QString& user)
@@ -375,7 +390,7 @@ void RecorderRoom::ensureStream(const QString& user)
     streams_.insert(user, st);
 }
 
-void RecorderRoom::handleAnnot(const QJsonObject& j)
+void RecorderRoom::handleAnnot(const QJsonObject& j, const QByteArray& bin)
 {
     if (j.value("roomId").toString() != roomId_) return;
     QString target = j.value("target").toString();
@@ -384,7 +399,8 @@ void RecorderRoom::handleAnnot(const QJsonObject& j)
     if (target.isEmpty()) return;
     auto* m = annotByUser_.value(target, nullptr);
     if (!m) { m = new AnnotModel(); annotByUser_.insert(target, m); }
-    m->applyEvent(j);
+    m->applyEvent(j, bin);
+    m->finishIdle();   // 没等到 end 的笔画超时后进缓存层，不再每帧现画
 }
 
 QImage RecorderRoom::parseDeltaIntoBack(const QString& sender, const QByteArray& blob, int w, int h)
@@ -423,21 +439,14 @@ void RecorderService::init(quint16 udpPort, const QString& kbRoot)
     udpPort_ = udpPort;
     kbRoot_ = kbRoot;
     QDir().mkpath(kbRoot_);
-    ensureTables();
-}
-
-void RecorderService::ensureTables()
-{
-    QSqlQuery q;
-    q.exec("CREATE TABLE IF NOT EXISTS recordings (id INTEGER PRIMARY KEY AUTOINCREMENT, order_id TEXT, room_id TEXT, started_at INTEGER, ended_at INTEGER, title TEXT)");
-    q.exec("CREATE TABLE IF NOT EXISTS recording_files (id INTEGER PRIMARY KEY AUTOINCREMENT, recording_id INTEGER, user TEXT, file_path TEXT, kind TEXT)");
+    // recordings/recording_files 由服务端启动时的统一迁移（第 1 步）建立
 }
 
 void RecorderService::onServerEventMembers(const QString& roomId, const QStringList& members)
 {
     RecorderRoom* room = rooms_.value(roomId, nullptr);
     if (!room) {
-        room = new RecorderRoom(roomId, udpPort_, this);
+        room = new RecorderRoom(roomId, udpPort_, db_, this);
         rooms_.insert(roomId, room);
     }
     room->membersUpdated(members);
@@ -453,7 +462,7 @@ void RecorderService::onPacketTCP(const QString& roomId, const Packet& p)
 {
     RecorderRoom* room = rooms_.value(roomId, nullptr);
     if (!room) {
-        room = new RecorderRoom(roomId, udpPort_, this);
+        room = new RecorderRoom(roomId, udpPort_, db_, this);
         rooms_.insert(roomId, room);
     }
     room->onTcpPacket(p);
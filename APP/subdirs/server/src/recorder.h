@@ -5,8 +5,11 @@
 #include <QProcess>
 #include "protocol.h"
 #include "annot.h"
+#include "videocodec.h"
 #include "udpmedia_client.h"
 
+class DbPool;
+
 class RecorderStream : public QObject {
     Q_OBJECT
 public:
@@ -53,7 +56,7 @@ private:
 class RecorderRoom : public QObject {
     Q_OBJECT
 public:
-    RecorderRoom(const QString& roomId, quint16 udpPort, QObject* parent=nullptr);
+    RecorderRoom(const QString& roomId, quint16 udpPort, DbPool* db, QObject* parent=nullptr);
     ~RecorderRoom();
 
     void membersUpdated(const QStringList& members);
@@ -64,7 +67,7 @@ public:
 
 private:
     void ensureStream(const QString& user);
-    void handleAnnot(const QJsonObject& j);
+    void handleAnnot(const QJsonObject& j, const QByteArray& bin);
     QImage parseDeltaIntoBack(const QString& sender, const QByteArray& blob, int w, int h);
 
     QString roomId_;
@@ -73,9 +76,11 @@ private:
     QHash<QString, RecorderStream*> streams_;
     QHash<QString, AnnotModel*> annotByUser_;
     QHash<QString, QImage> screenBack_;
+    QHash<QString, VideoCodec::CrDecoder> camDec_;   // 摄像头条件补充编码的解码状态
 
     UdpMediaClient udp_;
     quint16 udpPort_{0};
+    DbPool* db_{nullptr};
 };
 
 class RecorderService : public QObject {
@@ -84,6 +89,8 @@ public:
     explicit RecorderService(QObject* parent=nullptr);
 
     void init(quint16 udpPort, const QString& kbRoot = QStringLiteral("knowledge"));
+    // 录制入库走数据库池；未设置时在主线程直接写
+    void setDbPool(DbPool* db) { db_ = db; }
 
     // RoomHub hooks
     void onServerEventMembers(const QString& roomId, const QStringList& members);
@@ -93,5 +100,5 @@ private:
     QString kbRoot_;
     quint16 udpPort_{0};
     QHash<QString, RecorderRoom*> rooms_;
-    void ensureTables();
+    DbPool* db_{nullptr};
 };
@@ -1,7 +1,24 @@
 #include "roomhub.h"
 #include "recorder.h"
 
-RoomHub::RoomHub(QObject* parent) : QObject(parent) {}
+RoomHub::RoomHub(QObject* parent) : QObject(parent) {
+    mixer_ = new AudioMixer;
+    mixer_->moveToThread(&mixThread_);
+    connect(&mixThread_, &QThread::started, mixer_, &AudioMixer::start);
+    connect(&mixThread_, &QThread::finished, mixer_, &QObject::deleteLater);
+    connect(mixer_, &AudioMixer::mixReady, this, &RoomHub::onMixReady);
+    mixThread_.setObjectName("audio-mixer");
+    mixThread_.start(QThread::TimeCriticalPriority);
+
+    speakerTimer_.setInterval(kSpeakerTickMs);
+    connect(&speakerTimer_, &QTimer::timeout, this, &RoomHub::onSpeakerTick);
+    speakerTimer_.start();
+}
+
+RoomHub::~RoomHub() {
+    mixThread_.quit();
+    mixThread_.wait();
+}
 
 bool RoomHub::start(quint16 port) {
     connect(&server_, &QTcpServer::newConnection, this, &RoomHub::onNewConnection);
@@ -38,10 +55,24 @@ void RoomHub::onDisconnected() {
             if (i.value() == sock) i = rooms_.erase(i);
             else ++i;
         }
-        broadcastRoomMembers(oldRoom, "leave", c->user);
+        memberLeft(oldRoom, c->memberName);
+
+        auto sp = speakers_.find(oldRoom);
+        if (sp != speakers_.end()) {
+            sp->remove(c->user);
+            if (sp->isEmpty()) speakers_.erase(sp);
+        }
+        lastThumbMs_.remove(oldRoom + '\n' + c->user);
+        senderVideo_.remove(oldRoom + '\n' + c->user);
+        leaveRoomState(oldRoom, c->user);
+        if (c->subscribed) emit screenSubscriptionChanged(oldRoom, c->user, QStringList(), true);
     }
 
     clients_.erase(it);
+    if (!oldRoom.isEmpty()) {
+        syncMixerRoom(oldRoom);
+        updateDemand(oldRoom);
+    }
     sock->deleteLater();
     delete c;
 }
@@ -70,13 +101,21 @@ void RoomHub::handlePacket(ClientCtx* c, const Packet& p) {
             return;
         }
         c->user = user;
+        const QString prevRoom = c->roomId;
         joinRoom(c, roomId);
+        if (!prevRoom.isEmpty() && prevRoom != roomId) {
+            syncMixerRoom(prevRoom);
+            updateDemand(prevRoom);
+        }
+        syncMixerRoom(roomId);
 
         QJsonObject ack{{"code",0},{"message","joined"},{"roomId",roomId}};
         c->sock->write(buildPacket(MSG_SERVER_EVENT, ack));
 
+        // 新人拿全量成员表，其他人已在 joinRoom 里收到 join 增量
         sendRoomMembersTo(c->sock, roomId, "snapshot", c->user);
-        broadcastRoomMembers(roomId, "join", c->user);
+        sendRoomSnapshot(c);
+        updateDemand(roomId);
         return;
     }
 
@@ -86,8 +125,44 @@ void RoomHub::handlePacket(ClientCtx* c, const Packet& p) {
         return;
     }
 
-    // 录制服务同步 TCP 包（视频帧、标注等）
-    if (recorder_) recorder_->onPacketTCP(c->roomId, p);
+    // 客户端发现成员表版本断档：补发一次全量
+    if (p.type == MSG_CONTROL && p.json.value("kind").toString() == "members") {
+        sendRoomMembersTo(c->sock, c->roomId, "snapshot", c->user);
+        return;
+    }
+
+    // 接收端订阅：只在服务端消化，不转发
+    if (p.type == MSG_CONTROL && p.json.value("kind").toString() == "subscribe") {
+        handleSubscribe(c, p.json);
+        return;
+    }
+
+    // 录制服务同步 TCP 包（视频帧、标注等）；联播只录本帧编码出的最高层
+    if (recorder_ && p.json.value("layer").toInt(0) == p.json.value("top").toInt(0))
+        recorder_->onPacketTCP(c->roomId, p);
+
+    // 客户端音频能力声明：记下来供服务端混音选编码，同时照常转发给其他成员
+    if (p.type == MSG_CONTROL && p.json.value("kind").toString() == "audio") {
+        bool wb = false;
+        for (auto v : p.json.value("codecs").toArray()) wb |= (v.toString() == "adpcm16");
+        if (wb != c->wbAudio) {
+            c->wbAudio = wb;
+            if (mcuRooms_.contains(c->roomId)) syncMixerRoom(c->roomId);
+        }
+    }
+
+    if (p.type == MSG_AUDIO_FRAME) noteAudioLevel(c->roomId, p);
+
+    // MCU 房间：语音交给混音线程，不再逐路转发
+    if (p.type == MSG_AUDIO_FRAME && mcuRooms_.contains(c->roomId)) {
+        QMetaObject::invokeMethod(mixer_, "pushFrame", Qt::QueuedConnection,
+                                  Q_ARG(QString, c->roomId),
+                                  Q_ARG(QString, p.json.value("sender").toString()),
+                                  Q_ARG(QString, p.json.value("codec").toString("mulaw").toLower()),
+                                  Q_ARG(int, p.json.value("sr").toInt(8000)),
+                                  Q_ARG(QByteArray, p.bin));
+        return;
+    }
 
     if (p.type == MSG_TEXT ||
         p.type == MSG_DEVICE_DATA ||
@@ -114,9 +189,18 @@ void RoomHub::handlePacket(ClientCtx* c, const Packet& p) {
                     << "cmd="    << p.json.value("command").toString();
         }
 
+        if (p.type == MSG_CONTROL || p.type == MSG_ANNOT || p.type == MSG_TEXT || p.type == MSG_VIDEO_FRAME)
+            roomStates_[c->roomId].onPacket(p);
+
+        if (p.type == MSG_VIDEO_FRAME) {
+            bool priority = true;
+            const bool legacyOk = allowVideoFrame(c->roomId, p, &priority);
+            forwardVideo(c, p, legacyOk, priority);
+            return;
+        }
+
         QByteArray raw = buildPacket(p.type, p.json, p.bin);
-        const bool isVideo = (p.type == MSG_VIDEO_FRAME);
-        broadcastToRoom(c->roomId, raw, c->sock, isVideo);
+        broadcastToRoom(c->roomId, raw, c->sock, false);
         return;
     }
 
@@ -125,63 +209,445 @@ void RoomHub::handlePacket(ClientCtx* c, const Packet& p) {
 }
 
 void RoomHub::joinRoom(ClientCtx* c, const QString& roomId) {
+    const QString name = !c->user.isEmpty() ? c->user
+                                            : QString("peer-%1").arg(reinterpret_cast<quintptr>(c->sock));
+    const bool memberChanged = (c->roomId != roomId || c->memberName != name);
     if (!c->roomId.isEmpty()) {
         auto range = rooms_.equal_range(c->roomId);
         for (auto i = range.first; i != range.second; ) {
             if (i.value() == c->sock) i = rooms_.erase(i);
             else ++i;
         }
+        if (memberChanged) memberLeft(c->roomId, c->memberName);
+    }
+    if (c->roomId != roomId) {
+        // 换房间后旧订阅失效，等客户端按新房间重新订阅
+        if (c->subscribed) emit screenSubscriptionChanged(c->roomId, c->user, QStringList(), true);
+        c->subscribed = false;
+        c->lastN = 0;
+        c->subs.clear();
+        c->camOrder.clear();
+        c->lastNCams.clear();
+        c->demandSent = false;
+        c->curLayer.clear();
+        senderVideo_.remove(c->roomId + '\n' + c->user);
+        if (!c->roomId.isEmpty()) leaveRoomState(c->roomId, c->user);
     }
     c->roomId = roomId;
     rooms_.insert(roomId, c->sock);
+    if (memberChanged) {
+        c->memberName = name;
+        memberJoined(c);
+    }
+}
+
+// 入会应答和成员列表之后紧接着补发房间状态：各人的开关状态、标注、最近的文字和每路最近一帧画面
+void RoomHub::sendRoomSnapshot(ClientCtx* c) {
+    auto it = roomStates_.constFind(c->roomId);
+    if (it == roomStates_.constEnd()) return;
+    QHash<QString, int> camLayers;
+    const QVector<QByteArray> pkts = it.value().snapshot(c->roomId, &camLayers);
+    for (const QByteArray& raw : pkts) c->sock->write(raw);
+    // 快照给的是最低层关键帧，后续同层增量可以直接续上，等订阅生效后再在关键帧处换层
+    for (auto l = camLayers.constBegin(); l != camLayers.constEnd(); ++l)
+        c->curLayer.insert(l.key() + "/camera", l.value());
+    qInfo() << "[hub] room snapshot" << c->roomId << "->" << c->user << "packets=" << pkts.size();
+}
+
+void RoomHub::leaveRoomState(const QString& roomId, const QString& user) {
+    auto it = roomStates_.find(roomId);
+    if (it == roomStates_.end()) return;
+    if (!rooms_.contains(roomId)) roomStates_.erase(it);   // 最后一人离开，状态随房间一起丢弃
+    else it.value().removeSender(user);
 }
 
 void RoomHub::broadcastToRoom(const QString& roomId,
                               const QByteArray& packet,
                               QTcpSocket* except,
-                              bool dropVideoIfBacklog) {
+                              bool dropVideoIfBacklog,
+                              qint64 backlogLimit) {
     auto range = rooms_.equal_range(roomId);
     for (auto i = range.first; i != range.second; ++i) {
         QTcpSocket* s = i.value();
         if (s == except) continue;
-        if (dropVideoIfBacklog && s->bytesToWrite() > kBacklogDropThreshold) {
+        if (dropVideoIfBacklog && s->bytesToWrite() > backlogLimit) {
             continue;
         }
         s->write(packet);
     }
 }
 
-QStringList RoomHub::listMembers(const QString& roomId) const {
-    QStringList members;
+void RoomHub::syncMixerRoom(const QString& roomId) {
+    QStringList members, wb;
     auto range = rooms_.equal_range(roomId);
+    for (auto i = range.first; i != range.second; ++i) {
+        ClientCtx* c = clients_.value(i.value());
+        if (!c || c->user.isEmpty()) continue;
+        members << c->user;
+        if (c->wbAudio) wb << c->user;
+    }
+
+    // 进入/退出留一人的回差，避免成员在门限附近进出时来回切换
+    const bool was = mcuRooms_.contains(roomId);
+    const bool want = was ? members.size() >= kMcuMinMembers - 1
+                          : members.size() >= kMcuMinMembers;
+    if (want) {
+        if (!was) {
+            mcuRooms_.insert(roomId);
+            qInfo() << "[hub] room" << roomId << "-> server audio mixing, members=" << members.size();
+            broadcastToRoom(roomId, buildPacket(MSG_SERVER_EVENT, QJsonObject{
+                {"code", 0}, {"kind", "audio_mode"}, {"roomId", roomId}, {"mode", "mix"}}));
+        }
+        QMetaObject::invokeMethod(mixer_, "setRoom", Qt::QueuedConnection,
+                                  Q_ARG(QString, roomId), Q_ARG(QStringList, members), Q_ARG(QStringList, wb));
+    } else if (was) {
+        mcuRooms_.remove(roomId);
+        qInfo() << "[hub] room" << roomId << "-> per-sender audio forwarding, members=" << members.size();
+        QMetaObject::invokeMethod(mixer_, "removeRoom", Qt::QueuedConnection, Q_ARG(QString, roomId));
+        // 通知客户端混音流已结束，释放 "__mix__" 的播放槽位、恢复单路音量
+        broadcastToRoom(roomId, buildPacket(MSG_SERVER_EVENT, QJsonObject{
+            {"code", 0}, {"kind", "audio_mode"}, {"roomId", roomId}, {"mode", "forward"}}));
+    }
+}
+
+void RoomHub::noteAudioLevel(const QString& roomId, const Packet& p) {
+    const QString sender = p.json.value("sender").toString();
+    if (sender.isEmpty()) return;
+    const QString codec = p.json.value("codec").toString("mulaw").toLower();
+    const quint8* d = reinterpret_cast<const quint8*>(p.bin.constData());
+    int level = 0;
+    if (codec == "mulaw")        level = AudioCodec::ulawLevel(d, p.bin.size());
+    else if (codec == "adpcm16") level = AudioCodec::adpcmWbLevel(d, p.bin.size());
+    else return;   // cn 等静音标记：不计电平
+    speakers_[roomId].onAudio(sender, level, QDateTime::currentMSecsSinceEpoch());
+}
+
+// 返回值只约束未订阅的老客户端；priority 同时决定所有接收端的积压门限
+bool RoomHub::allowVideoFrame(const QString& roomId, const Packet& p, bool* priority) {
+    *priority = true;
+    // 屏幕共享始终全帧率；小房间不区分
+    if (p.json.value("media").toString("camera") == "screen") return true;
+    if (rooms_.count(roomId) < kVideoPrioMinMembers) return true;
+
+    const QString sender = p.json.value("sender").toString();
+    auto sp = speakers_.constFind(roomId);
+    if (sp != speakers_.constEnd()) {
+        const int rank = sp->rankOf(sender);
+        if (sender == sp->active() || (rank >= 0 && rank < kVideoTopN)) return true;
+    }
+
+    // 非主讲人：按缩略帧率放行；联播时老客户端只拿最低层
+    *priority = false;
+    const int layers = p.json.value("layers").toInt(1);
+    if (layers > 1 && p.json.value("layer").toInt(0) != layers - 1) return false;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64& last = lastThumbMs_[roomId + '\n' + sender];
+    const bool isKey = p.json.value("codec").toString() == "cr" && p.json.value("frame").toString() == "key";
+    if (!isKey && now - last < kThumbIntervalMs) return false;
+    last = now;
+    return true;
+}
+
+void RoomHub::handleSubscribe(ClientCtx* c, const QJsonObject& j) {
+    c->subscribed = true;
+    c->lastN = qMax(0, j.value("lastN").toInt(0));
+    c->subs.clear();
+    c->camOrder.clear();
+
+    QStringList screens;
+    for (auto v : j.value("streams").toArray()) {
+        const QJsonObject s = v.toObject();
+        const QString sender = s.value("sender").toString();
+        const QString media  = s.value("media").toString("camera");
+        if (sender.isEmpty() || sender == c->user) continue;
+
+        StreamSub sub;
+        sub.maxW = qMax(0, s.value("maxW").toInt(0));
+        sub.maxH = qMax(0, s.value("maxH").toInt(0));
+        sub.fps  = qBound(0, s.value("fps").toInt(0), 60);
+        const QString key = sender + '/' + media;
+        auto old = c->subs.constFind(key);
+        if (old != c->subs.constEnd()) sub.lastSentMs = old->lastSentMs;
+        c->subs.insert(key, sub);
+
+        if (media == "screen") screens << sender;
+        else if (!c->camOrder.contains(sender)) c->camOrder << sender;
+    }
+    updateLastN(c);
+
+    qInfo() << "[hub] subscribe" << "room=" << c->roomId << "user=" << c->user
+            << "streams=" << c->subs.size() << "lastN=" << c->lastN;
+    emit screenSubscriptionChanged(c->roomId, c->user, screens, false);
+    updateDemand(c->roomId);
+}
+
+void RoomHub::updateLastN(ClientCtx* c) {
+    c->lastNCams.clear();
+    if (c->lastN <= 0 || c->camOrder.size() <= c->lastN) {
+        for (const QString& s : c->camOrder) c->lastNCams.insert(s);
+        return;
+    }
+    // 最近发过言的优先，其余按客户端给出的顺序补足
+    auto sp = speakers_.constFind(c->roomId);
+    if (sp != speakers_.constEnd()) {
+        for (const QString& s : sp->recent()) {
+            if (c->lastNCams.size() >= c->lastN) return;
+            if (c->camOrder.contains(s)) c->lastNCams.insert(s);
+        }
+    }
+    for (const QString& s : c->camOrder) {
+        if (c->lastNCams.size() >= c->lastN) return;
+        c->lastNCams.insert(s);
+    }
+}
+
+void RoomHub::forwardVideo(ClientCtx* from, const Packet& p, bool legacyOk, bool priority) {
+    const QString sender = p.json.value("sender").toString();
+    const QString media  = p.json.value("media").toString("camera");
+    const QString key    = sender + '/' + media;
+    const qint64 limit   = priority ? qint64(kBacklogDropThreshold) : qint64(kThumbBacklogThreshold);
+    const qint64 now     = QDateTime::currentMSecsSinceEpoch();
+
+    // 联播：同一帧的各层依次到达，每个接收端只放行其中一层
+    const int layers = qBound(1, p.json.value("layers").toInt(1), int(kMaxSimLayers));
+    const int layer  = qBound(0, p.json.value("layer").toInt(0), layers - 1);
+    const int w0 = p.json.value("w").toInt() << layer;
+    const int h0 = p.json.value("h").toInt() << layer;
+    const int  top       = qBound(0, p.json.value("top").toInt(0), layers - 1);   // 本帧实际编码的第一层
+    const bool isKey     = (p.json.value("frame").toString() != "delta");   // 整帧 JPEG 或条件补充编码的关键帧
+    const bool crKey     = isKey && p.json.value("codec").toString() == "cr";
+    const bool frameHead = (layer == top);
+    if (media == "camera" && frameHead) {
+        SenderVideo& sv = senderVideo_[from->roomId + '\n' + sender];
+        sv.w0 = w0; sv.h0 = h0; sv.layers = layers;
+    }
+
+    QByteArray raw;   // 第一个需要的接收端出现时才打包
+    auto range = rooms_.equal_range(from->roomId);
     for (auto i = range.first; i != range.second; ++i) {
         QTcpSocket* s = i.value();
-        if (!clients_.contains(s)) continue;
-        auto* c = clients_.value(s);
-        if (!c->user.isEmpty()) members << c->user;
-        else members << QString("peer-%1").arg(reinterpret_cast<quintptr>(s));
+        if (s == from->sock) continue;
+        ClientCtx* rc = clients_.value(s);
+        if (!rc) continue;
+        if (layers > 1 && frameHead) updateLayerFloor(rc, now);
+
+        StreamSub* sub = nullptr;
+        int want = 0;
+        bool switched = false;
+        if (!rc->subscribed) {
+            if (!legacyOk) continue;
+            want = priority ? 0 : layers - 1;
+        } else {
+            auto it = rc->subs.find(key);
+            if (it == rc->subs.end()) continue;
+            if (media != "screen" && !rc->lastNCams.contains(sender)) continue;
+            sub = &it.value();
+            want = wantedLayer(*sub, w0, h0, layers);
+        }
+        // 需求提示生效前发送端可能还没编出想要的层，退而取本帧最高层
+        if (layers > 1) {
+            want = qMin(qMax(qMax(want, rc->layerFloor), top), layers - 1);
+            // 增量帧依赖同层关键帧：只在目标层的关键帧处换层，之前继续转发原来那层；
+            // 原来那层已不再编码（或还没转发过任何层）时接收端什么也收不到，向发送端索要目标层关键帧
+            auto cl = rc->curLayer.find(key);
+            if (cl == rc->curLayer.end()) cl = rc->curLayer.insert(key, -1);
+            int& cur = cl.value();
+            if (cur != want && layer == want && isKey) {
+                cur = want;
+                switched = true;
+            } else if (cur != want && (cur < top || cur >= layers) && frameHead) {
+                requestKeyframe(from, media, want, now);
+            }
+            if (layer != cur) continue;
+        }
+
+        if (sub) {
+            // 关键帧不受帧率限制，否则接收端要再等一个关键帧周期
+            if (sub->fps > 0 && !crKey && !switched && now - sub->lastSentMs < 1000 / sub->fps) continue;
+            sub->lastSentMs = now;
+        }
+        // 换层的那个关键帧不能丢：丢了之后的增量全都没有参考
+        if (!switched && s->bytesToWrite() > limit) continue;
+        if (raw.isEmpty()) raw = buildPacket(p.type, p.json, p.bin);
+        s->write(raw);
+    }
+}
+
+// 接收端等某层的关键帧时让发送端立刻补一个，不必等关键帧周期；按层限频
+void RoomHub::requestKeyframe(ClientCtx* from, const QString& media, int layer, qint64 now) {
+    qint64& last = from->keyReqMs[layer];
+    if (now - last < kKeyRequestMs) return;
+    last = now;
+    QJsonObject j{
+        {"code", 0},
+        {"kind", "keyframe"},
+        {"roomId", from->roomId},
+        {"media", media},
+        {"layer", layer}
+    };
+    from->sock->write(buildPacket(MSG_SERVER_EVENT, j));
+}
+
+// 取仍能铺满订阅窗口的最小一层；窗口比顶层还大或未给尺寸时用顶层
+int RoomHub::wantedLayer(const StreamSub& sub, int w0, int h0, int layers) {
+    if (sub.maxW <= 0 && sub.maxH <= 0) return 0;
+    int j = 0;
+    while (j + 1 < layers && (w0 >> (j + 1)) >= sub.maxW && (h0 >> (j + 1)) >= sub.maxH) ++j;
+    return j;
+}
+
+void RoomHub::updateLayerFloor(ClientCtx* rc, qint64 now) {
+    const qint64 backlog = rc->sock->bytesToWrite();
+    if (backlog > kLayerDownBacklog) {
+        if (rc->layerFloor < kMaxSimLayers - 1 && now - rc->layerStepMs >= kLayerStepMs) {
+            ++rc->layerFloor;
+            rc->layerStepMs = now;
+            qInfo() << "[hub] simulcast floor" << rc->user << "->" << rc->layerFloor << "backlog=" << backlog;
+        }
+        rc->layerCalmMs = now;
+    } else if (backlog > kLayerCalmBacklog) {
+        rc->layerCalmMs = now;
+    } else if (rc->layerFloor > 0 && now - rc->layerCalmMs >= kLayerUpMs
+               && now - rc->layerStepMs >= kLayerUpMs) {
+        --rc->layerFloor;
+        rc->layerStepMs = now;
+    }
+}
+
+// 汇总房间内各接收端的订阅，告诉每个发送端是否有人在看、最高需要哪一层
+// 只在结果变化时下发；老客户端没有订阅，按全部需要处理；
+// 录制服务没有单独的开始/停止，房间有人就在录，不能算作接收端（否则需求永远是“全要”）；
+// 它只收 layer == top 的帧，跟随观众需要的最高层录制，没人看的画面也就不录
+void RoomHub::updateDemand(const QString& roomId) {
+    QList<ClientCtx*> members;
+    auto range = rooms_.equal_range(roomId);
+    for (auto i = range.first; i != range.second; ++i) {
+        ClientCtx* c = clients_.value(i.value());
+        if (c && !c->user.isEmpty()) members << c;
+    }
+
+    for (ClientCtx* snd : members) {
+        const SenderVideo sv = senderVideo_.value(roomId + '\n' + snd->user);
+        const QString camKey = snd->user + "/camera";
+        const QString scrKey = snd->user + "/screen";
+        int  cam = -1;   // 0 为最大层
+        bool screen = false;
+        for (ClientCtx* rc : members) {
+            if (rc == snd) continue;
+            if (!rc->subscribed) { cam = 0; screen = true; break; }
+            auto it = rc->subs.constFind(camKey);
+            if (it != rc->subs.constEnd() && rc->lastNCams.contains(snd->user)) {
+                const int want = qMin(qMax(wantedLayer(*it, sv.w0, sv.h0, sv.layers), rc->layerFloor),
+                                      sv.layers - 1);
+                cam = (cam < 0) ? want : qMin(cam, want);
+            }
+            if (rc->subs.contains(scrKey)) screen = true;
+        }
+
+        if (snd->demandSent && cam == snd->camDemand && screen == snd->screenDemand) continue;
+        snd->demandSent   = true;
+        snd->camDemand    = cam;
+        snd->screenDemand = screen;
+        QJsonObject j{
+            {"code", 0},
+            {"kind", "demand"},
+            {"roomId", roomId},
+            {"camera", cam >= 0},
+            {"topLayer", qMax(0, cam)},
+            {"screen", screen}
+        };
+        snd->sock->write(buildPacket(MSG_SERVER_EVENT, j));
+    }
+}
+
+void RoomHub::onSpeakerTick() {
+    // last-N 与带宽估计都会随时间变化，顺带刷新各房间的发送需求
+    for (const QString& roomId : rooms_.uniqueKeys()) updateDemand(roomId);
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = speakers_.begin(); it != speakers_.end(); ++it) {
+        const bool changed = it->update(now);
+
+        // 发言顺序变了，重新挑选各订阅端的 last-N
+        auto range = rooms_.equal_range(it.key());
+        for (auto i = range.first; i != range.second; ++i) {
+            ClientCtx* c = clients_.value(i.value());
+            if (c && c->subscribed && c->lastN > 0) updateLastN(c);
+        }
+
+        if (!changed) continue;
+        QJsonObject j{
+            {"code", 0},
+            {"kind", "speaker"},
+            {"event", "active"},
+            {"roomId", it.key()},
+            {"who", it->active()},
+            {"ranking", QJsonArray::fromStringList(it->ranking().mid(0, kVideoTopN))},
+            {"ts", now}
+        };
+        broadcastToRoom(it.key(), buildPacket(MSG_SERVER_EVENT, j), nullptr, false);
+    }
+}
+
+void RoomHub::onMixReady(const QString& roomId, const AudioMixBatch& packets) {
+    if (!mcuRooms_.contains(roomId)) return;   // 已退出混音：混音线程里排队的最后一批不再下发
+    auto range = rooms_.equal_range(roomId);
+    for (auto i = range.first; i != range.second; ++i) {
+        ClientCtx* c = clients_.value(i.value());
+        if (!c) continue;
+        auto it = packets.constFind(c->user);
+        if (it != packets.constEnd()) c->sock->write(it.value());
+    }
+}
+
+QStringList RoomHub::listMembers(const QString& roomId) const {
+    auto it = members_.constFind(roomId);
+    return it == members_.constEnd() ? QStringList() : QStringList(it->users.keys());
+}
+
+void RoomHub::memberJoined(ClientCtx* c) {
+    RoomMembers& m = members_[c->roomId];
+    if (++m.users[c->memberName] > 1) return;   // 同名的另一条连接，成员集合不变
+    ++m.version;
+    broadcastRoomMembers(c->roomId, "join", c->memberName, c->sock);
+}
+
+void RoomHub::memberLeft(const QString& roomId, const QString& name) {
+    auto it = members_.find(roomId);
+    if (it == members_.end()) return;
+    RoomMembers& m = it.value();
+    auto u = m.users.find(name);
+    if (u == m.users.end()) return;
+    if (--u.value() > 0) return;
+    m.users.erase(u);
+    ++m.version;
+    if (m.users.isEmpty()) {
+        members_.erase(it);
+        if (recorder_) recorder_->onServerEventMembers(roomId, QStringList());
+        return;
     }
-    members.removeDuplicates();
-    members.sort();
-    return members;
+    broadcastRoomMembers(roomId, "leave", name);
 }
 
-void RoomHub::broadcastRoomMembers(const QString& roomId, const QString& event, const QString& whoChanged) {
+// 只发增量；收到的一方版本号不连续时发 {kind:"members"} 要全量
+void RoomHub::broadcastRoomMembers(const QString& roomId, const QString& event, const QString& whoChanged,
+                                   QTcpSocket* except) {
+    const RoomMembers m = members_.value(roomId);
     QJsonObject j{
         {"code", 0},
         {"kind", "room"},
         {"event", event},
         {"roomId", roomId},
         {"who", whoChanged},
-        {"members", QJsonArray::fromStringList(listMembers(roomId))},
+        {"version", double(m.version)},
         {"ts", QDateTime::currentMSecsSinceEpoch()}
     };
     QByteArray pkt = buildPacket(MSG_SERVER_EVENT, j);
 
     // 通知录制服务最新成员
-    if (recorder_) recorder_->onServerEventMembers(roomId, listMembers(roomId));
+    if (recorder_) recorder_->onServerEventMembers(roomId, m.users.keys());
 
-    broadcastToRoom(roomId, pkt, nullptr, false);
+    broadcastToRoom(roomId, pkt, except, false);
 }
 
 void RoomHub::sendRoomMembersTo(QTcpSocket* target, const QString& roomId, const QString& event, const QString& whoChanged) {
@@ -193,6 +659,7 @@ void RoomHub::sendRoomMembersTo(QTcpSocket* target, const QString& roomId, const
         {"roomId", roomId},
         {"who", whoChanged},
         {"members", QJsonArray::fromStringList(listMembers(roomId))},
+        {"version", double(members_.value(roomId).version)},
         {"ts", QDateTime::currentMSecsSinceEpoch()}
     };
     target->write(buildPacket(MSG_SERVER_EVENT, j));
@@ -2,20 +2,65 @@
 #include <QtCore>
 #include <QtNetwork>
 #include "protocol.h"
+#include "audiomixer.h"
+#include "activespeaker.h"
+#include "roomstate.h"
 
 class RecorderService; // 前向声明
 
+// 接收端对某一路视频（sender + media）的订阅
+struct StreamSub {
+    int maxW = 0, maxH = 0;   // 期望的最大分辨率（0 表示不限）
+    int fps = 0;              // 最大帧率（0 表示不限）
+    qint64 lastSentMs = 0;
+};
+
 struct ClientCtx {
     QTcpSocket* sock = nullptr;
     QString user;
     QString roomId;
+    QString memberName;     // 登记在房间成员表里的名字（无用户名时为 peer-<socket>）
     QByteArray buffer;
+    bool wbAudio = false;   // 客户端声明支持 adpcm16
+
+    // 选择性转发：未发过订阅的老客户端照旧全收
+    bool subscribed = false;
+    int  lastN = 0;                      // 摄像头路数上限（0 表示不限）
+    QHash<QString, StreamSub> subs;      // "sender/media" -> 订阅
+    QStringList camOrder;                // 订阅里摄像头发送者的原始顺序
+    QSet<QString> lastNCams;             // 当前 last-N 选中的摄像头发送者
+
+    // 联播挑层的带宽估计：发送积压持续偏高时整体降一层，长时间畅通再回升
+    QHash<QString, int> curLayer;   // "sender/media" -> 正在转发的联播层（只在关键帧处切换）
+    int    layerFloor  = 0;
+    qint64 layerStepMs = 0;
+    qint64 layerCalmMs = 0;
+
+    // 作为发送端的需求：上次下发给它的 demand 提示
+    bool demandSent   = false;
+    int  camDemand    = 0;      // 有人要看时为所需的最高层（0 为顶层），-1 表示没人看
+    bool screenDemand = true;
+    QHash<int, qint64> keyReqMs;   // 联播层 -> 上次向它索要关键帧的时间
+};
+
+// 房间成员表：按名字排序，同名多连接只算一人；成员集合每变一次版本号加一
+// 广播只发 join/leave 增量和版本号，全量只给新入会者和发现版本断档的客户端
+struct RoomMembers {
+    QMap<QString, int> users;   // 名字 -> 连接数
+    quint64 version = 0;
+};
+
+// 发送端最近一帧摄像头的联播信息，用于按订阅尺寸推算各层需求
+struct SenderVideo {
+    int w0 = 640, h0 = 480;   // 顶层尺寸
+    int layers = 1;
 };
 
 class RoomHub : public QObject {
     Q_OBJECT
 public:
     explicit RoomHub(QObject* parent=nullptr);
+    ~RoomHub();
     bool start(quint16 port);
 
     // 注入录制服务
@@ -25,6 +70,13 @@ private slots:
     void onNewConnection();
     void onReadyRead();
     void onDisconnected();
+    void onMixReady(const QString& roomId, const AudioMixBatch& packets);
+    void onSpeakerTick();
+
+signals:
+    // 屏幕共享走 UDP 中继，订阅结果同步给 UdpRelay 过滤（all=true 表示不过滤）
+    void screenSubscriptionChanged(const QString& roomId, const QString& user,
+                                   const QStringList& senders, bool all);
 
 private:
     QTcpServer server_;
@@ -32,16 +84,61 @@ private:
     QMultiHash<QString, QTcpSocket*> rooms_; // roomId -> sockets
 
     static constexpr qint64 kBacklogDropThreshold = 3 * 1024 * 1024; // 3MB
+    static constexpr int    kMcuMinMembers = 6;  // 成员数达到此值的房间改由服务端混音
+
+    // 说话人优先的视频转发：前 N 名说话人全帧率，其余降到缩略帧率
+    static constexpr int    kVideoTopN             = 2;
+    static constexpr int    kVideoPrioMinMembers   = 4;    // 小房间不做区分
+    static constexpr int    kThumbIntervalMs       = 1000; // 缩略帧率：1fps
+    static constexpr qint64 kThumbBacklogThreshold = 1 * 1024 * 1024; // 非主讲人视频更早让路
+    static constexpr int    kSpeakerTickMs         = 250;
+
+    // 摄像头联播
+    static constexpr int    kMaxSimLayers      = 3;
+    static constexpr qint64 kLayerDownBacklog  = 512 * 1024;
+    static constexpr qint64 kLayerCalmBacklog  = 64 * 1024;
+    static constexpr int    kLayerStepMs       = 1000;
+    static constexpr int    kLayerUpMs         = 5000;
+    static constexpr int    kKeyRequestMs      = 1000;   // 同一层索要关键帧的最短间隔
+
+    // 服务端混音：独立线程，只通过排队调用交互
+    QThread     mixThread_;
+    AudioMixer* mixer_ = nullptr;
+    QSet<QString> mcuRooms_;
+
+    QHash<QString, ActiveSpeakerTracker> speakers_;   // roomId -> 说话人排名
+    QHash<QString, qint64> lastThumbMs_;              // roomId + '\n' + sender -> 上次转发缩略帧时间
+    QTimer speakerTimer_;
+    QHash<QString, SenderVideo> senderVideo_;         // roomId + '\n' + sender
+    QHash<QString, RoomState> roomStates_;            // roomId -> 给中途入会者的快照
+    QHash<QString, RoomMembers> members_;             // roomId -> 成员表
 
     void handlePacket(ClientCtx* c, const Packet& p);
     void joinRoom(ClientCtx* c, const QString& roomId);
     void broadcastToRoom(const QString& roomId,
                          const QByteArray& packet,
                          QTcpSocket* except = nullptr,
-                         bool dropVideoIfBacklog = false);
+                         bool dropVideoIfBacklog = false,
+                         qint64 backlogLimit = kBacklogDropThreshold);
+
+    void syncMixerRoom(const QString& roomId);
+    void noteAudioLevel(const QString& roomId, const Packet& p);
+    bool allowVideoFrame(const QString& roomId, const Packet& p, bool* priority);
+    void handleSubscribe(ClientCtx* c, const QJsonObject& j);
+    void updateLastN(ClientCtx* c);
+    void forwardVideo(ClientCtx* from, const Packet& p, bool legacyOk, bool priority);
+    void updateLayerFloor(ClientCtx* rc, qint64 now);
+    void requestKeyframe(ClientCtx* from, const QString& media, int layer, qint64 now);
+    static int wantedLayer(const StreamSub& sub, int w0, int h0, int layers);
+    void updateDemand(const QString& roomId);
+    void sendRoomSnapshot(ClientCtx* c);
+    void leaveRoomState(const QString& roomId, const QString& user);
 
     QStringList listMembers(const QString& roomId) const;
-    void broadcastRoomMembers(const QString& roomId, const QString& event, const QString& whoChanged);
+    void memberJoined(ClientCtx* c);
+    void memberLeft(const QString& roomId, const QString& name);
+    void broadcastRoomMembers(const QString& roomId, const QString& event, const QString& whoChanged,
+                              QTcpSocket* except = nullptr);
     void sendRoomMembersTo(QTcpSocket* target, const QString& roomId, const QString& event, const QString& whoChanged);
 
     RecorderService* recorder_{nullptr};
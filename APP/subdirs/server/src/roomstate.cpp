@@ -0,0 +1,78 @@
+#include "roomstate.h"
+
+void RoomState::onPacket(const Packet& p)
+{
+    const QString sender = p.json.value("sender").toString();
+
+    if (p.type == MSG_CONTROL) {
+        const QString kind = p.json.value("kind").toString();
+        if (sender.isEmpty() || kind.isEmpty()) return;
+        controls_.insert(sender + '\n' + kind, p);
+        // 关掉的画面不再给新人看旧帧
+        if (p.json.value("state").toString() == "off") {
+            if (kind == "视频" || kind == "video") frames_.remove(sender + "\ncamera");
+            else if (kind == "screen")              frames_.remove(sender + "\nscreen");
+        }
+    } else if (p.type == MSG_ANNOT) {
+        QString target = p.json.value("target").toString();
+        if (target == QStringLiteral("__local__")) target = sender;
+        if (target.isEmpty()) return;
+        AnnotModel& m = annots_[target];
+        m.applyEvent(p.json, p.bin);
+        m.finishIdle();
+    } else if (p.type == MSG_TEXT) {
+        chat_.append(p);
+        while (chat_.size() > kChatTail) chat_.removeFirst();
+    } else if (p.type == MSG_VIDEO_FRAME) {
+        if (sender.isEmpty()) return;
+        const QString media = p.json.value("media").toString("camera");
+        if (media == "camera") {
+            // 只留最低层（缩略图尺寸、总会被编码）的关键帧
+            const int layers = qMax(1, p.json.value("layers").toInt(1));
+            if (p.json.value("layer").toInt(0) != layers - 1) return;
+            if (p.json.value("frame").toString() == "delta") return;
+        }
+        frames_.insert(sender + '\n' + media, p);
+    }
+}
+
+void RoomState::removeSender(const QString& user)
+{
+    const QString prefix = user + '\n';
+    for (auto it = controls_.begin(); it != controls_.end(); )
+        it = it.key().startsWith(prefix) ? controls_.erase(it) : std::next(it);
+    for (auto it = frames_.begin(); it != frames_.end(); )
+        it = it.key().startsWith(prefix) ? frames_.erase(it) : std::next(it);
+    annots_.remove(user);   // 离开者画面上的标注随画面一起消失，别人画的其它标注保留
+    // 离开者在别人画面上没画完的笔画按已结束重放，新人那边不会一直挂着进行中的笔画
+    for (AnnotModel& m : annots_) m.finishOwner(user);
+}
+
+QVector<QByteArray> RoomState::snapshot(const QString& roomId, QHash<QString, int>* cameraLayers) const
+{
+    QVector<QByteArray> out;
+    auto replay = [&](quint16 type, QJsonObject j, const QByteArray& bin){
+        j["replay"] = true;
+        out.append(buildPacket(type, j, bin));
+    };
+
+    for (const Packet& p : controls_) replay(p.type, p.json, p.bin);
+
+    for (auto it = annots_.constBegin(); it != annots_.constEnd(); ++it) {
+        for (const auto& ev : it.value().snapshotEvents()) {
+            QJsonObject j = ev.first;
+            j["roomId"] = roomId;
+            j["target"] = it.key();
+            replay(MSG_ANNOT, j, ev.second);
+        }
+    }
+
+    for (const Packet& p : chat_) replay(p.type, p.json, p.bin);
+
+    for (const Packet& p : frames_) {
+        replay(p.type, p.json, p.bin);
+        if (cameraLayers && p.json.value("media").toString("camera") == "camera")
+            cameraLayers->insert(p.json.value("sender").toString(), p.json.value("layer").toInt(0));
+    }
+    return out;
+}
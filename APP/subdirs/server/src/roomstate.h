@@ -0,0 +1,28 @@
+#pragma once
+#include <QtCore>
+#include "protocol.h"
+#include "annot.h"
+
+// 单个房间的当前状态，供中途入会的成员在入会应答后一次补齐：
+// - 每个发送者各类 MSG_CONTROL 的最新一条（摄像头/屏幕开关、音频能力等）
+// - 每个标注目标的标注模型，重放成 begin/end 事件
+// - 每个发送者摄像头最低联播层的最近关键帧、TCP 屏幕的最近一帧
+// - 最近 kChatTail 条文字消息
+class RoomState {
+public:
+    // 记录转发中的包；只保留能还原画面的那部分
+    void onPacket(const Packet& p);
+    void removeSender(const QString& user);
+
+    // 快照包按 控制 -> 标注 -> 文字 -> 画面 的顺序排列，json 带 "replay":true
+    // cameraLayers 回填快照里每个摄像头发送者所给的联播层，转发端据此续上增量帧
+    QVector<QByteArray> snapshot(const QString& roomId, QHash<QString, int>* cameraLayers) const;
+
+private:
+    static constexpr int kChatTail = 50;
+
+    QHash<QString, Packet>     controls_;   // sender + '\n' + kind
+    QHash<QString, AnnotModel> annots_;     // 标注目标
+    QHash<QString, Packet>     frames_;     // sender + '\n' + media
+    QList<Packet>              chat_;
+};
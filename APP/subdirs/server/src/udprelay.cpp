@@ -59,10 +59,13 @@ void UdpRelay::onReadyRead()
             const auto now = QDateTime::currentMSecsSinceEpoch();
             auto it = rooms_.find(room);
             if (it != rooms_.end()) {
+                const auto subs = screenSubs_.value(room);
                 for (auto pit = it->begin(); pit != it->end(); ++pit) {
                     const Peer& peer = pit.value();
                     if (now - peer.lastSeen > 10000) continue;
                     if (peer.addr == from && peer.port == port) continue;
+                    auto sit = subs.constFind(pit.key());
+                    if (sit != subs.constEnd() && !sit->contains(sender)) continue;
                     sock_.writeDatagram(d, peer.addr, peer.port);
                 }
             }
@@ -70,6 +73,21 @@ void UdpRelay::onReadyRead()
     }
 }
 
+void UdpRelay::setScreenSubscription(const QString& roomId, const QString& user,
+                                     const QStringList& senders, bool all)
+{
+    if (all) {
+        auto it = screenSubs_.find(roomId);
+        if (it == screenSubs_.end()) return;
+        it->remove(user);
+        if (it->isEmpty()) screenSubs_.erase(it);
+        return;
+    }
+    QSet<QString>& set = screenSubs_[roomId][user];
+    set.clear();
+    for (const QString& s : senders) set.insert(s);
+}
+
 void UdpRelay::onCleanup()
 {
     const qint64 now = QDateTime::currentMSecsSinceEpoch();
@@ -82,5 +100,8 @@ void UdpRelay::onCleanup()
         for (const auto& u : rmUsers) it->remove(u);
         if (it->isEmpty()) emptyRooms << it.key();
     }
-    for (const auto& k : emptyRooms) rooms_.remove(k);
+    for (const auto& k : emptyRooms) {
+        rooms_.remove(k);
+        screenSubs_.remove(k);
+    }
 }
@@ -10,6 +10,11 @@ public:
     bool start(quint16 port);
     quint16 port() const { return port_; }
 
+public slots:
+    // 接收端的屏幕共享订阅（来自 RoomHub）；all=true 表示不过滤
+    void setScreenSubscription(const QString& roomId, const QString& user,
+                               const QStringList& senders, bool all);
+
 private slots:
     void onReadyRead();
     void onCleanup();
@@ -22,6 +27,8 @@ private:
     };
     // roomId -> user -> Peer
     QHash<QString, QHash<QString, Peer>> rooms_;
+    // roomId -> user -> 想看的屏幕发送者；没有条目的用户照旧全收
+    QHash<QString, QHash<QString, QSet<QString>>> screenSubs_;
     QUdpSocket sock_;
     quint16 port_{0};
     QTimer cleanup_;